@@ -59,6 +59,13 @@ void DemoAudioProcessorEditor::initializeUIComponents()
         audioProcessor.getApvts(), "logLevel", logLevelComboBox);
     logLevelComboBox.addListener(this);
 
+    addAndMakeVisible(binaryLogButton);
+    binaryLogButton.setButtonText("Binary Log");
+    binaryLogButton.setVisible(false);
+    binaryLogAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(
+        audioProcessor.getApvts(), "binaryLogEnable", binaryLogButton);
+    binaryLogButton.addListener(this);
+
     addAndMakeVisible(dataDumpButton);
     dataDumpButton.setButtonText("Data Dump");
     dataDumpButton.setVisible(false);
@@ -66,6 +73,11 @@ void DemoAudioProcessorEditor::initializeUIComponents()
         audioProcessor.getApvts(), "dataDumpEnable", dataDumpButton);
     dataDumpButton.addListener(this);
 
+    addAndMakeVisible(flightRecordButton);
+    flightRecordButton.setButtonText("Save Last 10 s");
+    flightRecordButton.setVisible(false);
+    flightRecordButton.addListener(this);
+
     addAndMakeVisible(bypassButton);
     bypassButton.setButtonText("Bypass");
     bypassButton.setClickingTogglesState(true);
@@ -113,7 +125,9 @@ DemoAudioProcessorEditor::~DemoAudioProcessorEditor()
     versionButton.removeListener(this);
     versionButton.setLookAndFeel(nullptr);
     logLevelComboBox.removeListener(this);
+    binaryLogButton.removeListener(this);
     dataDumpButton.removeListener(this);
+    flightRecordButton.removeListener(this);
 
     bypassButton.removeListener(this);
     bypassButton.setLookAndFeel(nullptr);
@@ -155,7 +169,11 @@ void DemoAudioProcessorEditor::resized()
     int bottom = EDITOR_HEIGHT - BUTTON_HEIGHT - MARGIN;
     versionButton.setBounds(MARGIN, bottom, BUTTON_WIDTH, BUTTON_HEIGHT);
     logLevelComboBox.setBounds((int)((EDITOR_WIDTH - BUTTON_WIDTH) / 2), bottom, BUTTON_WIDTH, BUTTON_HEIGHT);
+    binaryLogButton.setBounds((int)((EDITOR_WIDTH - BUTTON_WIDTH) / 2), bottom - BUTTON_HEIGHT - MARGIN, BUTTON_WIDTH,
+                              BUTTON_HEIGHT);
     dataDumpButton.setBounds(EDITOR_WIDTH - BUTTON_WIDTH - MARGIN, bottom, BUTTON_WIDTH, BUTTON_HEIGHT);
+    flightRecordButton.setBounds(EDITOR_WIDTH - BUTTON_WIDTH - MARGIN, bottom - BUTTON_HEIGHT - MARGIN, BUTTON_WIDTH,
+                                 BUTTON_HEIGHT);
 
     LOG_MSG(LOG_DEBUG, "UI resized");
 }
@@ -166,17 +184,29 @@ void DemoAudioProcessorEditor::buttonClicked(juce::Button *button)
         versionButtonClickedTimes++;
         if (versionButtonClickedTimes == 5) {
             logLevelComboBox.setVisible(true);
+            binaryLogButton.setVisible(true);
             dataDumpButton.setVisible(true);
+            flightRecordButton.setVisible(true);
             versionButtonClickedTimes = -5;
         } else if (versionButtonClickedTimes == 0) {
             logLevelComboBox.setVisible(false);
+            binaryLogButton.setVisible(false);
             dataDumpButton.setVisible(false);
+            flightRecordButton.setVisible(false);
         }
+    } else if (button == &binaryLogButton) {
+        audioProcessor.getLogger().setBinaryLog(binaryLogButton.getToggleState());
+        LOG_MSG(LOG_INFO, "Binary log is " + std::string(binaryLogButton.getToggleState() ? "enabled" : "disabled"));
     } else if (button == &dataDumpButton) {
-        audioProcessor.setDataDumpState(dataDumpButton.getToggleState());
         LOG_MSG(LOG_INFO, "Data dump is " + std::string(audioProcessor.getDataDumpState() ? "enabled" : "disabled"));
+    } else if (button == &flightRecordButton) {
+        if (audioProcessor.isFlightRecorderActive()) {
+            audioProcessor.captureFlightRecording();
+            LOG_MSG(LOG_INFO, "Flight recording requested");
+        } else {
+            LOG_MSG(LOG_WARN, "Flight recorder is not running, nothing to save");
+        }
     } else if (button == &bypassButton) {
-        audioProcessor.setBypassState(bypassButton.getToggleState());
         LOG_MSG(LOG_INFO, "Bypass is " + std::string(audioProcessor.getBypassState() ? "enabled" : "disabled"));
     } else {
         // program should not reach here
@@ -187,14 +217,8 @@ void DemoAudioProcessorEditor::buttonClicked(juce::Button *button)
 void DemoAudioProcessorEditor::sliderValueChanged(juce::Slider *slider)
 {
     if (slider == &gainSlider) {
-        audioProcessor.setGainValue(static_cast<float>(gainSlider.getValue()));
-        float gainValue = audioProcessor.getGainValue();
-        int ret = algo_set_param(audioProcessor.getAlgoHandle(), ALGO_PARAM2, &gainValue, (int)sizeof(float));
-        if (ret != E_OK) {
-            LOG_MSG(LOG_ERROR, "algo_set_param failed. ret = " + std::to_string(ret));
-        } else {
-            LOG_MSG(LOG_INFO, "Gain value changed to " + std::to_string(gainValue) + " dB");
-        }
+        // The attachment has already updated the parameter, the audio thread picks it up at the next block
+        LOG_MSG(LOG_INFO, "Gain value changed to " + std::to_string(gainSlider.getValue()) + " dB");
     }
 }
 
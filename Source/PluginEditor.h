@@ -93,8 +93,11 @@ private:
     juce::TextButton versionButton;
     juce::ComboBox logLevelComboBox;
     std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> logLevelAttachment;
+    juce::ToggleButton binaryLogButton;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> binaryLogAttachment;
     juce::ToggleButton dataDumpButton;
     std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> dataDumpAttachment;
+    juce::TextButton flightRecordButton;
     juce::ToggleButton bypassButton;
     std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> bypassAttachment;
     juce::Slider gainSlider;
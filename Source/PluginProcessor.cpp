@@ -20,6 +20,25 @@
 #define MAX_GAIN_VALUE 20.0f
 #define MIN_GAIN_VALUE -20.0f
 
+// Internal frame sizes offered by the "frameSize" parameter, 0 is the zero-latency mode
+static const int kFrameSizes[] = {0, 32, 64, 128, 256, 512, 1024, 2048, 4096};
+static const int kDefaultFrameSizeIndex = 7;
+
+// File name of each data dump tap, in DumpTap order
+static const char *const kDumpTapFileNames[] = {"input", "pre_algo", "processed", "output"};
+
+// Limits offered by the data dump retention parameters, 0 is no limit
+static const uint64_t kDumpRetentionBytes[] = {0, 1ull << 30, 10ull << 30, 50ull << 30, 200ull << 30};
+static const int kDumpRetentionDays[] = {0, 1, 7, 30, 90};
+static const int kDumpRetentionFiles[] = {0, 100, 1000, 10000};
+
+// Value of a choice parameter in the table of its choices
+template <typename T, size_t N>
+static T pickChoice(const T (&choices)[N], const std::atomic<float> *param)
+{
+    return choices[juce::jlimit(0, static_cast<int>(N) - 1, static_cast<int>(param->load()))];
+}
+
 //==============================================================================
 class RegistrationComponent : public juce::Component
 {
@@ -64,8 +83,11 @@ void DemoAudioProcessor::initializeBuffers()
 {
     try {
         for (int channel = 0; channel < MAX_SUPPORT_CHANNELS; channel++) {
-            writeBuf[channel] = std::make_unique<float[]>(blockSize);
-            readBuf[channel] = std::make_unique<float[]>(blockSize);
+            // sized for the largest frame so that changing the frame size never allocates
+            writeBuf[channel] = std::make_unique<float[]>(kMaxBlockSize);
+            readBuf[channel] = std::make_unique<float[]>(kMaxBlockSize);
+            writeBufDouble[channel] = std::make_unique<double[]>(kMaxBlockSize);
+            readBufDouble[channel] = std::make_unique<double[]>(kMaxBlockSize);
         }
     } catch (const std::bad_alloc &e) {
         LOG_MSG(LOG_ERROR, "Failed to allocate memory: " + std::string(e.what()));
@@ -167,6 +189,8 @@ DemoAudioProcessor::~DemoAudioProcessor()
     for (int channel = 0; channel < MAX_SUPPORT_CHANNELS; channel++) {
         writeBuf[channel].reset();
         readBuf[channel].reset();
+        writeBufDouble[channel].reset();
+        readBufDouble[channel].reset();
     }
     if (algo_handle != nullptr) {
         algo_deinit(algo_handle);
@@ -306,6 +330,10 @@ void DemoAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
             new OpenLogCallback());
     }
 
+    if (isInitDone) {
+        configureFrameSize();
+    }
+
     if (!toReleaseResources) {
         originalSampleRate = sampleRate;
         originalChannels = getTotalNumInputChannels();
@@ -313,8 +341,6 @@ void DemoAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
                               ", samplesPerBlock=" + std::to_string(samplesPerBlock) +
                               ", about " + std::to_string(samplesPerBlock * 1000.0f / sampleRate) + " ms");
 
-        setLatencySamples(blockSize);
-        LOG_MSG(LOG_INFO, "set latency samples: " + std::to_string(blockSize));
         processBlockCounter = 0;
 
         juce::File UserDesktop = juce::File::getSpecialLocation(juce::File::userDesktopDirectory);
@@ -325,26 +351,57 @@ void DemoAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
             LOG_MSG(LOG_ERROR, "Failed to create data dump folder: \"" +
                                    dataDumpDir.getFullPathName().toStdString() + "\"");
         }
+        // the first time the folder is set, the sessions already in it are indexed in the background
+        dumpHousekeeper->setPolicy(loadRetentionPolicy());
+        dumpHousekeeper->setDirectory(dataDumpDir);
 
         auto now = std::chrono::system_clock::now();
         std::time_t now_time = std::chrono::system_clock::to_time_t(now);
         char timeStr[20] = {0};
         std::strftime(timeStr, sizeof(timeStr), "%Y-%m-%d_%H%M%S_", std::localtime(&now_time));
         juce::String TimeStamp = juce::String(timeStr);
-        dataDumpFile = dataDumpDir.getChildFile(TimeStamp + "processed.pcm");
-        if (dataDumpFile.create().wasOk()) {
-            LOG_MSG(LOG_DEBUG, "Created data dump file: \"" +
-                                   dataDumpFile.getFullPathName().toStdString() + "\"");
-            if ((dataDumpFilePtr = fopen(dataDumpFile.getFullPathName().toUTF8(), "ab+")) == nullptr) {
-                LOG_MSG(LOG_ERROR, "Failed to open data dump file: \"" +
+        // only read here, a change takes effect the next time playback is prepared
+        const bool compressDump = dataDumpFormatParam->load() >= 0.5f;
+        for (int tap = 0; tap < NumDumpTaps; tap++) {
+            dumpTapStreams[tap] = -1;
+            if (dumpTapParams[tap]->load() < 0.5f) {
+                continue;
+            }
+            juce::File dataDumpFile = dataDumpDir.getChildFile(TimeStamp + kDumpTapFileNames[tap] +
+                                                               (compressDump ? ".pdz" : ".wav"));
+            if (dataDumpFile.create().wasOk()) {
+                LOG_MSG(LOG_DEBUG, "Created data dump file: \"" +
                                        dataDumpFile.getFullPathName().toStdString() + "\"");
+                dumpTapStreams[tap] = dataDumpWriter.addStream(
+                    dataDumpFile, sampleRate, juce::jmin(originalChannels, MAX_SUPPORT_CHANNELS),
+                    compressDump ? myDumpWriter::Format::Compressed : myDumpWriter::Format::Wav);
             } else {
-                LOG_MSG(LOG_DEBUG, "Opened data dump file: \"" +
+                LOG_MSG(LOG_ERROR, "Failed to create data dump file: \"" +
                                        dataDumpFile.getFullPathName().toStdString() + "\"");
             }
-        } else {
-            LOG_MSG(LOG_ERROR, "Failed to create data dump file: \"" +
-                                   dataDumpFile.getFullPathName().toStdString() + "\"");
+        }
+        bool anyDumpTap = false;
+        for (int tap = 0; tap < NumDumpTaps; tap++) {
+            anyDumpTap |= dumpTapStreams[tap] >= 0;
+        }
+        if (anyDumpTap) {
+            // frame boundaries, parameters and timings of the session, for replaying the dumps offline
+            juce::File dumpMetaFile = dataDumpDir.getChildFile(TimeStamp + "frames.pdmeta");
+            dumpMetaStream = dataDumpWriter.addStream(dumpMetaFile, sampleRate, 1, myDumpWriter::Format::Raw);
+        }
+        dataDumpWriter.start();
+        if (dumpMetaStream >= 0) {
+            char version[32] = {0};
+            get_algo_version(version);
+            encodeDumpMetaFileHeader(dumpMetaHeader,
+                                     static_cast<uint16_t>(juce::jmin(originalChannels, MAX_SUPPORT_CHANNELS)),
+                                     static_cast<uint32_t>(sampleRate), version);
+            // written with the first frame record, a session without dumping leaves an empty file to be removed
+            dumpMetaHeaderPending = true;
+        }
+        if (flightRecorderParam->load() >= 0.5f) {
+            flightRecorder.prepare(dataDumpDir, sampleRate, juce::jmin(originalChannels, MAX_SUPPORT_CHANNELS),
+                                   kFlightRecorderSeconds);
         }
         toReleaseResources = true;
     } else {
@@ -352,32 +409,64 @@ void DemoAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
     }
 }
 
+void DemoAudioProcessor::configureFrameSize()
+{
+    const int numFrameSizes = static_cast<int>(sizeof(kFrameSizes) / sizeof(kFrameSizes[0]));
+    int index = juce::jlimit(0, numFrameSizes - 1, static_cast<int>(frameSizeParam->load()));
+    int newBlockSize = kFrameSizes[index];
+    if (newBlockSize != blockSize) {
+        // prepareToPlay never runs concurrently with processBlock, so the FIFO can be reset here
+        blockSize = newBlockSize;
+        writeIndex = 0;
+        readIndex = 0;
+        for (int channel = 0; channel < MAX_SUPPORT_CHANNELS; channel++) {
+            std::fill_n(writeBuf[channel].get(), kMaxBlockSize, 0.0f);
+            std::fill_n(readBuf[channel].get(), kMaxBlockSize, 0.0f);
+            std::fill_n(writeBufDouble[channel].get(), kMaxBlockSize, 0.0);
+            std::fill_n(readBufDouble[channel].get(), kMaxBlockSize, 0.0);
+        }
+        // queued offsets point into the old frame, drop them and queue the next change against the applied gain
+        numGainEvents = 0;
+        queuedGain = appliedGain;
+    }
+    setLatencySamples(blockSize);
+    LOG_MSG(LOG_INFO, "internal frame size: " + std::to_string(blockSize) +
+                          ", set latency samples: " + std::to_string(blockSize));
+}
+
+myDumpHousekeeper::RetentionPolicy DemoAudioProcessor::loadRetentionPolicy() const
+{
+    myDumpHousekeeper::RetentionPolicy policy;
+    policy.maxTotalBytes = pickChoice(kDumpRetentionBytes, dumpRetentionSizeParam);
+    policy.maxAgeDays = pickChoice(kDumpRetentionDays, dumpRetentionAgeParam);
+    policy.maxFiles = pickChoice(kDumpRetentionFiles, dumpRetentionFilesParam);
+    return policy;
+}
+
 void DemoAudioProcessor::releaseResources()
 {
     // When playback stops, you can use this as an opportunity to free up any
     // spare memory, etc.
     if (toReleaseResources) {
-        if (dataDumpFilePtr) {
-            if (fflush(dataDumpFilePtr) == 0) {
-                LOG_MSG(LOG_DEBUG, "Flushed data dump file: \"" +
-                                       dataDumpFile.getFullPathName().toStdString() + "\"");
-            } else {
-                LOG_MSG(LOG_ERROR, "Failed to flush data dump file: \"" +
-                                       dataDumpFile.getFullPathName().toStdString() + "\"");
-            }
-            if (fclose(dataDumpFilePtr) == 0) {
-                LOG_MSG(LOG_DEBUG, "Closed data dump file: \"" +
-                                       dataDumpFile.getFullPathName().toStdString() + "\"");
-            } else {
-                LOG_MSG(LOG_ERROR, "Failed to close data dump file: \"" +
-                                       dataDumpFile.getFullPathName().toStdString() + "\"");
+        juce::Array<juce::File> sessionFiles;
+        for (int tap = 0; tap < NumDumpTaps; tap++) {
+            if (dumpTapStreams[tap] >= 0) {
+                sessionFiles.add(dataDumpWriter.getFile(dumpTapStreams[tap]));
             }
         }
-        if (processBlockCounter) {
-            convertPCMtoWAV(dataDumpFile, static_cast<uint16_t>(validChannels),
-                            static_cast<uint32_t>(originalSampleRate), 32, 3);
+        if (dumpMetaStream >= 0) {
+            sessionFiles.add(dataDumpWriter.getFile(dumpMetaStream));
         }
-        deleteEmptyFilesAndFolders(dataDumpDir);
+        // writes whatever the audio thread queued and patches the final sizes into the WAV headers
+        dataDumpWriter.close();
+        std::fill_n(dumpTapStreams, NumDumpTaps, -1);
+        dumpMetaStream = -1;
+        // saves a recording that was still pending
+        flightRecorder.release();
+        sessionFiles.addArray(flightRecorder.takeSavedFiles());
+        // empty files and the retention policy are dealt with on the housekeeping thread
+        dumpHousekeeper->addFiles(sessionFiles);
+        dumpHousekeeper->requestCleanup();
         processBlockCounter = 0;
         toReleaseResources = false;
         LOG_MSG(LOG_INFO, "released Resources");
@@ -411,7 +500,189 @@ bool DemoAudioProcessor::isBusesLayoutSupported(const BusesLayout &layouts) cons
 }
 #endif
 
+static int algoProcessMulti(void *handle, const float *const *input, float *const *output, int numChannels,
+                            int numSamples)
+{
+    return algo_process_multi(handle, input, output, numChannels, numSamples);
+}
+
+static int algoProcessMulti(void *handle, const double *const *input, double *const *output, int numChannels,
+                            int numSamples)
+{
+    return algo_process_multi_double(handle, input, output, numChannels, numSamples);
+}
+
+void DemoAudioProcessor::queueGainEvent(int offset, float gainValue)
+{
+    if (gainValue == queuedGain) {
+        return;
+    }
+    queuedGain = gainValue;
+    // A later change at the same offset, or one that does not fit any more, replaces the newest event
+    if (numGainEvents > 0 &&
+        (gainEvents[numGainEvents - 1].offset == offset || numGainEvents == kMaxGainEvents)) {
+        gainEvents[numGainEvents - 1].gain = gainValue;
+        return;
+    }
+    gainEvents[numGainEvents].offset = offset;
+    gainEvents[numGainEvents].gain = gainValue;
+    numGainEvents++;
+}
+
+void DemoAudioProcessor::applyGain(float gainValue)
+{
+    if (gainValue == appliedGain) {
+        return;
+    }
+    // the audio thread is the only one that changes the gain inside the algorithm
+    if (algo_set_param(algo_handle, ALGO_PARAM2, &gainValue, (int)sizeof(float)) == E_OK) {
+        appliedGain = gainValue;
+    }
+}
+
+template <typename SampleType>
+int DemoAudioProcessor::processFrame(const SampleType *const *input, SampleType *const *output, int frameSize)
+{
+    const SampleType *subInput[MAX_SUPPORT_CHANNELS] = {0};
+    SampleType *subOutput[MAX_SUPPORT_CHANNELS] = {0};
+    int start = 0;
+    int ret = E_OK;
+    for (int event = 0; event <= numGainEvents; event++) {
+        // an offset never lies beyond the frame, clamp it in case the frame got shorter since it was queued
+        int stop = event < numGainEvents ? juce::jmin(gainEvents[event].offset, frameSize) : frameSize;
+        if (stop > start) {
+            for (int channel = 0; channel < validChannels; channel++) {
+                subInput[channel] = input[channel] + start;
+                subOutput[channel] = output[channel] + start;
+            }
+            int subRet = algoProcessMulti(algo_handle, subInput, subOutput, validChannels, stop - start);
+            if (subRet != E_OK) {
+                ret = subRet;
+                // a failed call leaves the output alone, pass the input through as processing in place did
+                copyFrame(subInput, subOutput, stop - start);
+            }
+            start = stop;
+        }
+        if (event < numGainEvents) {
+            applyGain(gainEvents[event].gain);
+        }
+    }
+    numGainEvents = 0;
+    return ret;
+}
+
+bool DemoAudioProcessor::supportsDoublePrecisionProcessing() const
+{
+    return true;
+}
+
 void DemoAudioProcessor::processBlock(juce::AudioBuffer<float> &buffer, juce::MidiBuffer &midiMessages)
+{
+    juce::ignoreUnused(midiMessages);
+    processBlockInternal(buffer, writeBuf, readBuf);
+}
+
+void DemoAudioProcessor::processBlock(juce::AudioBuffer<double> &buffer, juce::MidiBuffer &midiMessages)
+{
+    juce::ignoreUnused(midiMessages);
+    processBlockInternal(buffer, writeBufDouble, readBufDouble);
+}
+
+DemoAudioProcessor::ParamSnapshot DemoAudioProcessor::loadParamSnapshot() const
+{
+    ParamSnapshot params;
+    params.gain = gainParam->load(std::memory_order_relaxed);
+    params.bypassEnable = bypassParam->load(std::memory_order_relaxed) >= 0.5f;
+    params.dataDumpEnable = dataDumpParam->load(std::memory_order_relaxed) >= 0.5f;
+    return params;
+}
+
+void DemoAudioProcessor::dumpFrameRecord(DumpFrameRecord &record, const ParamSnapshot &params)
+{
+    if (!params.dataDumpEnable || dumpMetaStream < 0) {
+        return;
+    }
+    if (dumpMetaHeaderPending) {
+        // a frame record without the header in front of it would make the file unreadable
+        if (!dataDumpWriter.pushRecord(dumpMetaStream, dumpMetaHeader, sizeof(dumpMetaHeader))) {
+            return;
+        }
+        dumpMetaHeaderPending = false;
+    }
+    record.frameIndex = algoFrameCounter;
+    record.blockIndex = processBlockCounter - 1;
+    uint8_t encoded[kDumpMetaMaxRecordBytes];
+    dataDumpWriter.pushRecord(dumpMetaStream, encoded, encodeDumpFrameRecord(record, encoded));
+}
+
+template <typename SampleType>
+void DemoAudioProcessor::runFrame(const SampleType *const *input, SampleType *const *output, int frameSize,
+                                  const ParamSnapshot &params)
+{
+    // the gain events are consumed by processing, so the record takes them first
+    DumpFrameRecord record;
+    record.frameSize = static_cast<uint32_t>(frameSize);
+    record.gainAtStart = appliedGain;
+    record.numGainEvents = static_cast<uint32_t>(numGainEvents);
+    for (int event = 0; event < numGainEvents; event++) {
+        record.gainEvents[event].offset = static_cast<uint32_t>(gainEvents[event].offset);
+        record.gainEvents[event].gain = gainEvents[event].gain;
+    }
+    if (std::is_same<SampleType, double>::value) {
+        record.flags |= kDumpMetaDoublePrecision;
+    }
+    if (dumpMetaHeaderPending && params.dataDumpEnable) {
+        // a replay starts from the gain ramp as it is in front of the frame the header goes out with
+        algo_gain_ramp_t ramp;
+        if (algo_get_param(algo_handle, ALGO_PARAM_GAIN_RAMP, &ramp, (int)sizeof(ramp)) == E_OK) {
+            DumpMetaGainRamp metaRamp;
+            metaRamp.current = ramp.current;
+            metaRamp.target = ramp.target;
+            metaRamp.step = ramp.step;
+            metaRamp.remaining = static_cast<uint32_t>(ramp.remaining);
+            encodeDumpMetaGainRamp(dumpMetaHeader, metaRamp);
+        }
+    }
+
+    if (params.bypassEnable) {
+        // do nothing or copy the input buffer to the output buffer
+        copyFrame(input, output, frameSize);
+        if (numGainEvents > 0) {
+            applyGain(gainEvents[numGainEvents - 1].gain);
+            numGainEvents = 0;
+        }
+        record.flags |= kDumpMetaBypass;
+        dumpFrameRecord(record, params);
+        return;
+    }
+
+    if (dumpTap(DumpTapPreAlgo, input, frameSize, params)) {
+        record.flags |= kDumpMetaPreAlgoCaptured;
+    }
+    auto frameStart = juce::Time::getMillisecondCounterHiRes();
+    int ret = processFrame(input, output, frameSize);
+    if (ret != 0) {
+        LOG_RT(LOG_ERROR, "Failed to algo_process. ret = %d", ret);
+        flightRecorder.trigger(myFlightRecorder::Trigger::AlgoError);
+    }
+    auto frameStop = juce::Time::getMillisecondCounterHiRes();
+    if (frameStop - frameStart > frameSize * 1000.0 / originalSampleRate) {
+        flightRecorder.trigger(myFlightRecorder::Trigger::DeadlineMiss);
+    }
+    LOG_RT(LOG_DEBUG, "algo_process frame %llu elapsed time: %f ms", algoFrameCounter, frameStop - frameStart);
+    if (dumpTap(DumpTapPostAlgo, output, frameSize, params)) {
+        record.flags |= kDumpMetaPostAlgoCaptured;
+    }
+    record.processMs = static_cast<float>(frameStop - frameStart);
+    record.result = ret;
+    dumpFrameRecord(record, params);
+    algoFrameCounter++;
+}
+
+template <typename SampleType>
+void DemoAudioProcessor::processBlockInternal(juce::AudioBuffer<SampleType> &buffer,
+                                              std::unique_ptr<SampleType[]> (&writeBufs)[MAX_SUPPORT_CHANNELS],
+                                              std::unique_ptr<SampleType[]> (&readBufs)[MAX_SUPPORT_CHANNELS])
 {
     if (!isLicenseValid || !isInitDone) {
         return;
@@ -419,67 +690,105 @@ void DemoAudioProcessor::processBlock(juce::AudioBuffer<float> &buffer, juce::Mi
 
     // auto startTime = juce::Time::getMillisecondCounterHiRes();
     juce::ScopedNoDenormals noDenormals;
+    const ParamSnapshot params = loadParamSnapshot();
     auto totalNumInputChannels = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
     validChannels = juce::jmin(totalNumInputChannels, MAX_SUPPORT_CHANNELS);
     int numSamples = buffer.getNumSamples();
     if (processBlockCounter++ == 0) {
         originalChannels = totalNumInputChannels;
-        LOG_MSG(LOG_INFO, "processBlock: numSamples=" + std::to_string(numSamples) +
-                              ", totalNumInputChannels=" + std::to_string(totalNumInputChannels) +
-                              ", totalNumOutputChannels=" + std::to_string(totalNumOutputChannels) +
-                              ", about " + std::to_string(numSamples * 1000.0f / originalSampleRate) + " ms");
+        LOG_RT(LOG_INFO,
+               "processBlock: numSamples=%d, totalNumInputChannels=%d, totalNumOutputChannels=%d, about %f ms",
+               numSamples, totalNumInputChannels, totalNumOutputChannels, numSamples * 1000.0f / originalSampleRate);
+    }
+    dumpTap(DumpTapInput, buffer.getArrayOfReadPointers(), numSamples, params);
+    flightRecorder.record(myFlightRecorder::TrackInput, buffer.getArrayOfReadPointers(), validChannels, numSamples);
+
+    const bool doublePrecision = std::is_same<SampleType, double>::value;
+    if (doublePrecision != fifoIsDouble) {
+        // The host switched the precision without preparing again. The indices belong to the other FIFO,
+        // so start this one empty instead of playing what was left in it.
+        fifoIsDouble = doublePrecision;
+        writeIndex = 0;
+        readIndex = 0;
+        for (int channel = 0; channel < MAX_SUPPORT_CHANNELS; channel++) {
+            std::fill_n(writeBufs[channel].get(), kMaxBlockSize, SampleType(0));
+            std::fill_n(readBufs[channel].get(), kMaxBlockSize, SampleType(0));
+        }
+        numGainEvents = 0;
+        queuedGain = appliedGain;
+    }
+
+    if (blockSize == 0) {
+        // zero-latency mode: the gain works on any length, so process the host buffer directly
+        SampleType *channels[MAX_SUPPORT_CHANNELS] = {0};
+        for (int channel = 0; channel < validChannels; channel++) {
+            channels[channel] = buffer.getWritePointer(channel);
+        }
+        queueGainEvent(0, params.gain);
+        if (numSamples > 0) {
+            runFrame(channels, channels, numSamples, params);
+        }
+        dumpTap(DumpTapOutput, buffer.getArrayOfReadPointers(), numSamples, params);
+        flightRecorder.record(myFlightRecorder::TrackOutput, buffer.getArrayOfReadPointers(), validChannels,
+                              numSamples);
+        return;
+    }
+
+    // Aligned fast path: a whole frame of the host buffer is processed straight into writeBuf, which
+    // saves the copy into the FIFO, then the previous frame goes out of readBuf and the two swap roles.
+    // Only the unaligned remainder goes through the FIFO below.
+    int alignedSamples = 0;
+    if (writeIndex == 0 && readIndex == 0) {
+        alignedSamples = numSamples - numSamples % blockSize;
+    }
+    const SampleType *frame[MAX_SUPPORT_CHANNELS] = {0};
+    SampleType *pProcessed[MAX_SUPPORT_CHANNELS] = {0};
+    for (int frameStart = 0; frameStart < alignedSamples; frameStart += blockSize) {
+        for (int channel = 0; channel < validChannels; channel++) {
+            frame[channel] = buffer.getReadPointer(channel, frameStart);
+            pProcessed[channel] = writeBufs[channel].get();
+        }
+        queueGainEvent(0, params.gain);
+        runFrame(frame, pProcessed, blockSize, params);
+        for (int channel = 0; channel < validChannels; channel++) {
+            std::memcpy(buffer.getWritePointer(channel, frameStart), readBufs[channel].get(),
+                        blockSize * sizeof(SampleType));
+            writeBufs[channel].swap(readBufs[channel]);
+        }
     }
 
-    int bufferIndex = 0;
-    float *pWrite[MAX_SUPPORT_CHANNELS] = {0};
-    float *pRead[MAX_SUPPORT_CHANNELS] = {0};
+    int bufferIndex = alignedSamples;
+    SampleType *pWrite[MAX_SUPPORT_CHANNELS] = {0};
+    SampleType *pRead[MAX_SUPPORT_CHANNELS] = {0};
     while (bufferIndex != numSamples) {
         for (int channel = 0; channel < validChannels; channel++) {
-            pWrite[channel] = writeBuf[channel].get();
-            pRead[channel] = readBuf[channel].get();
+            pWrite[channel] = writeBufs[channel].get();
+            pRead[channel] = readBufs[channel].get();
         }
         int numSamplesWrite = 0;
         numSamplesWrite = juce::jmin(numSamples - bufferIndex, blockSize - writeIndex);
         numSamplesWrite = juce::jmin(numSamplesWrite, blockSize - readIndex);
+        // The new gain takes effect at the sample where this host block lands in the internal frame
+        queueGainEvent(writeIndex, params.gain);
         for (int channel = 0; channel < validChannels; channel++) {
             std::memcpy(pWrite[channel] + writeIndex,
                         buffer.getReadPointer(channel, bufferIndex),
-                        numSamplesWrite * sizeof(float));
+                        numSamplesWrite * sizeof(SampleType));
         }
         writeIndex += numSamplesWrite;
         if (writeIndex == blockSize) {
-            if (bypassEnable) {
-                // do nothing or copy the input buffer to the output buffer
-            } else {
-                auto frameStart = juce::Time::getMillisecondCounterHiRes();
-                for (int channel = 0; channel < validChannels; channel++) {
-                    int ret = algo_process(algo_handle, pWrite[channel], pWrite[channel], blockSize);
-                    if (ret != 0) {
-                        LOG_MSG(LOG_ERROR, "Failed to algo_process. ret = " + std::to_string(ret));
-                    }
-                }
-                auto frameStop = juce::Time::getMillisecondCounterHiRes();
-                LOG_MSG(LOG_DEBUG, "algo_process frame " + std::to_string(algoFrameCounter++) +
-                                       " elapsed time: " + std::to_string(frameStop - frameStart) + " ms");
-                if (dataDumpEnable) {
-                    for (int channel = 0; channel < validChannels; channel++) {
-                        for (int sample = 0; sample < blockSize; sample++) {
-                            fwrite(writeBuf[channel].get() + sample, sizeof(float), 1, dataDumpFilePtr);
-                        }
-                    }
-                }
-            }
+            runFrame(pWrite, pWrite, blockSize, params);
         }
         for (int channel = 0; channel < validChannels; channel++) {
             std::memcpy(buffer.getWritePointer(channel, bufferIndex),
                         pRead[channel] + readIndex,
-                        numSamplesWrite * sizeof(float));
+                        numSamplesWrite * sizeof(SampleType));
         }
         bufferIndex += numSamplesWrite;
         if (writeIndex == blockSize) {
             for (int channel = 0; channel < validChannels; channel++) {
-                writeBuf[channel].swap(readBuf[channel]);
+                writeBufs[channel].swap(readBufs[channel]);
             }
             writeIndex = 0;
         }
@@ -488,6 +797,8 @@ void DemoAudioProcessor::processBlock(juce::AudioBuffer<float> &buffer, juce::Mi
             readIndex = 0;
         }
     }
+    dumpTap(DumpTapOutput, buffer.getArrayOfReadPointers(), numSamples, params);
+    flightRecorder.record(myFlightRecorder::TrackOutput, buffer.getArrayOfReadPointers(), validChannels, numSamples);
 
     // auto stopTime = juce::Time::getMillisecondCounterHiRes();
     // auto elapsedTime = stopTime - startTime;
@@ -537,28 +848,16 @@ void DemoAudioProcessor::setStateInformation(const void *data, int sizeInBytes)
             LOG_MSG(LOG_INFO, "Log level has been set to " +
                                   std::to_string(apvts.getRawParameterValue("logLevel")->load()) + " by last state");
         }
-        bool lastDataDumpEnableState = static_cast<bool>(apvts.getRawParameterValue("dataDumpEnable")->load());
-        if (dataDumpEnable != lastDataDumpEnableState) {
-            dataDumpEnable = lastDataDumpEnableState;
-            LOG_MSG(LOG_INFO, "Data dump is " + std::string(dataDumpEnable ? "enabled" : "disabled") + " by last state");
-        }
-        bool lastBypassEnableState = static_cast<bool>(apvts.getRawParameterValue("bypassEnable")->load());
-        if (bypassEnable != lastBypassEnableState) {
-            bypassEnable = lastBypassEnableState;
-            LOG_MSG(LOG_INFO, "Bypass is " + std::string(bypassEnable ? "enabled" : "disabled") + " by last state");
-        }
-        float lastGainValue = apvts.getRawParameterValue("gain")->load();
-        if (gain != lastGainValue) {
-            gain = lastGainValue;
-            if (algo_handle != nullptr) {
-                int ret = algo_set_param(algo_handle, ALGO_PARAM2, &gain, (int)sizeof(float));
-                if (ret != E_OK) {
-                    LOG_MSG(LOG_ERROR, "algo_set_param failed. ret = " + std::to_string(ret));
-                } else {
-                    LOG_MSG(LOG_INFO, "Gain value has been set to " + std::to_string(gain) + " dB by last state");
-                }
-            }
+        const bool lastBinaryLog = apvts.getRawParameterValue("binaryLogEnable")->load() > 0.5f;
+        if (getLogger().isBinaryLog() != lastBinaryLog) {
+            getLogger().setBinaryLog(lastBinaryLog);
+            LOG_MSG(LOG_INFO,
+                    "Binary log is " + std::string(lastBinaryLog ? "enabled" : "disabled") + " by last state");
         }
+        // gain, bypass and data dump reach the audio thread through the parameter atomics
+        LOG_MSG(LOG_INFO, "Data dump is " + std::string(getDataDumpState() ? "enabled" : "disabled") + " by last state");
+        LOG_MSG(LOG_INFO, "Bypass is " + std::string(getBypassState() ? "enabled" : "disabled") + " by last state");
+        LOG_MSG(LOG_INFO, "Gain value has been set to " + std::to_string(getGainValue()) + " dB by last state");
     } else {
         if (!tree.hasType("Parameters")) {
             LOG_MSG(LOG_DEBUG, "Read from memory block: " + tree.toXmlString().toStdString());
@@ -572,12 +871,36 @@ void DemoAudioProcessor::setStateInformation(const void *data, int sizeInBytes)
 juce::AudioProcessorValueTreeState::ParameterLayout DemoAudioProcessor::createParameters()
 {
     juce::AudioProcessorValueTreeState::ParameterLayout paramsLayout;
+    // VST2 hosts address parameters by index, so new ones are only ever appended
     paramsLayout.add(std::make_unique<juce::AudioParameterChoice>(
         "logLevel", "Log Level", juce::StringArray{"DEBUG", "INFO", "WARN", "ERROR", "OFF"}, 1));
     paramsLayout.add(std::make_unique<juce::AudioParameterBool>("dataDumpEnable", "Data Dump", false));
     paramsLayout.add(std::make_unique<juce::AudioParameterBool>("bypassEnable", "Bypass", false));
     paramsLayout.add(std::make_unique<juce::AudioParameterFloat>(
         "gain", "Gain", juce::NormalisableRange<float>(MIN_GAIN_VALUE, MAX_GAIN_VALUE, 0.001f), 0.0f));
+    // only read in prepareToPlay, a change takes effect the next time playback is prepared
+    paramsLayout.add(std::make_unique<juce::AudioParameterChoice>(
+        "frameSize", "Frame Size",
+        juce::StringArray{"0 (no latency)", "32", "64", "128", "256", "512", "1024", "2048", "4096"},
+        kDefaultFrameSizeIndex));
+    paramsLayout.add(std::make_unique<juce::AudioParameterChoice>(
+        "dataDumpFormat", "Data Dump Format", juce::StringArray{"WAV", "Lossless compressed (.pdz)"}, 0));
+    paramsLayout.add(std::make_unique<juce::AudioParameterBool>("dumpTapInput", "Dump Host Input", false));
+    paramsLayout.add(std::make_unique<juce::AudioParameterBool>("dumpTapPreAlgo", "Dump Pre-Algorithm", false));
+    paramsLayout.add(std::make_unique<juce::AudioParameterBool>("dumpTapPostAlgo", "Dump Post-Algorithm", true));
+    paramsLayout.add(std::make_unique<juce::AudioParameterBool>("dumpTapOutput", "Dump Host Output", false));
+    paramsLayout.add(std::make_unique<juce::AudioParameterBool>("flightRecorderEnable", "Flight Recorder", false));
+    // only read in prepareToPlay, they apply to the sessions in the data dump folder, older ones first;
+    // unlimited by default so that an update never deletes dumps that were kept on purpose
+    paramsLayout.add(std::make_unique<juce::AudioParameterChoice>(
+        "dumpRetentionSize", "Data Dump Size Limit",
+        juce::StringArray{"Unlimited", "1 GB", "10 GB", "50 GB", "200 GB"}, 0));
+    paramsLayout.add(std::make_unique<juce::AudioParameterChoice>(
+        "dumpRetentionAge", "Data Dump Age Limit",
+        juce::StringArray{"Unlimited", "1 day", "7 days", "30 days", "90 days"}, 0));
+    paramsLayout.add(std::make_unique<juce::AudioParameterChoice>(
+        "dumpRetentionFiles", "Data Dump File Limit", juce::StringArray{"Unlimited", "100", "1000", "10000"}, 0));
+    paramsLayout.add(std::make_unique<juce::AudioParameterBool>("binaryLogEnable", "Binary Log", false));
     return paramsLayout;
 }
 
@@ -16,6 +16,10 @@
 
 #pragma once
 
+#include "myDumpHousekeeper.h"
+#include "myDumpMeta.h"
+#include "myDumpWriter.h"
+#include "myFlightRecorder.h"
 #include "myLogger.h"
 #include "myUtils.h"
 #include <JuceHeader.h>
@@ -47,6 +51,8 @@ public:
 #endif
 
     void processBlock(juce::AudioBuffer<float> &, juce::MidiBuffer &) override;
+    void processBlock(juce::AudioBuffer<double> &, juce::MidiBuffer &) override;
+    bool supportsDoublePrecisionProcessing() const override;
 
     //==============================================================================
     juce::AudioProcessorEditor *createEditor() override;
@@ -75,15 +81,15 @@ public:
     int getUserPluginType() const { return pluginType; }
     const std::string &getUserHostAppName() const { return hostAppName; }
     int getUserHostAppVersion() const { return hostAppVersion; }
-    void setDataDumpState(bool state) { dataDumpEnable = state; }
-    bool getDataDumpState() const { return dataDumpEnable; }
+    bool getDataDumpState() const { return dataDumpParam->load(std::memory_order_relaxed) >= 0.5f; }
+    // Saves the last kFlightRecorderSeconds of input and output next to the data dumps, from any thread
+    void captureFlightRecording() { flightRecorder.trigger(myFlightRecorder::Trigger::Request); }
+    bool isFlightRecorderActive() const { return flightRecorder.isPrepared(); }
 
     void initializeBuffers();
 
-    void setBypassState(bool state) { bypassEnable = state; }
-    bool getBypassState() const { return bypassEnable; }
-    void setGainValue(float value) { gain = value; }
-    float getGainValue() const { return gain; }
+    bool getBypassState() const { return bypassParam->load(std::memory_order_relaxed) >= 0.5f; }
+    float getGainValue() const { return gainParam->load(std::memory_order_relaxed); }
     void *getAlgoHandle() const { return algo_handle; }
 
     juce::AudioProcessorValueTreeState &getApvts() { return apvts; }
@@ -92,13 +98,64 @@ public:
     myLogger &getLogger() const { return myLogger::getInstance(); }
 
 private:
+    // Parameter values the audio thread works with for one whole block
+    struct ParamSnapshot {
+        float gain = 0.0f;
+        bool bypassEnable = false;
+        bool dataDumpEnable = false;
+    };
+    ParamSnapshot loadParamSnapshot() const;
+
+    // Gain change time-stamped with the sample offset inside the internal frame where it takes effect
+    struct GainEvent {
+        int offset = 0;
+        float gain = 0.0f;
+    };
+    static constexpr int kMaxGainEvents = 32; // bounds the number of kernel calls per frame
+    void queueGainEvent(int offset, float gainValue);
+    void applyGain(float gainValue);
+    void configureFrameSize();
+    myDumpHousekeeper::RetentionPolicy loadRetentionPolicy() const;
+
+    // Capture points of the data dump, each enabled one streams into its own file
+    enum DumpTap {
+        DumpTapInput = 0, // host buffer as it arrives
+        DumpTapPreAlgo,   // internal frame before algo_process
+        DumpTapPostAlgo,  // internal frame after algo_process
+        DumpTapOutput,    // host buffer as it leaves, one internal frame after DumpTapPostAlgo
+        NumDumpTaps
+    };
+    // The dump stays 32-bit float whatever the processing precision is, a full ring drops the frame.
+    // Returns whether the frame was queued.
+    template <typename SampleType>
+    bool dumpTap(DumpTap tap, const SampleType *const *channels, int numSamples, const ParamSnapshot &params)
+    {
+        if (params.dataDumpEnable && dumpTapStreams[tap] >= 0) {
+            return dataDumpWriter.pushFrame(dumpTapStreams[tap], channels, validChannels, numSamples);
+        }
+        return false;
+    }
+    // Queues the sidecar record of one internal frame, see myDumpMeta
+    void dumpFrameRecord(DumpFrameRecord &record, const ParamSnapshot &params);
+
     //==============================================================================
     juce::AudioProcessorValueTreeState apvts{*this, nullptr, "Parameters", createParameters()};
+    // APVTS raw parameter atomics, written by the host/editor and read lock-free by the audio thread
+    std::atomic<float> *gainParam = apvts.getRawParameterValue("gain");
+    std::atomic<float> *bypassParam = apvts.getRawParameterValue("bypassEnable");
+    std::atomic<float> *dataDumpParam = apvts.getRawParameterValue("dataDumpEnable");
+    std::atomic<float> *frameSizeParam = apvts.getRawParameterValue("frameSize");
+    std::atomic<float> *dataDumpFormatParam = apvts.getRawParameterValue("dataDumpFormat");
+    std::atomic<float> *dumpTapParams[NumDumpTaps] = {
+        apvts.getRawParameterValue("dumpTapInput"), apvts.getRawParameterValue("dumpTapPreAlgo"),
+        apvts.getRawParameterValue("dumpTapPostAlgo"), apvts.getRawParameterValue("dumpTapOutput")};
+    std::atomic<float> *flightRecorderParam = apvts.getRawParameterValue("flightRecorderEnable");
+    std::atomic<float> *dumpRetentionSizeParam = apvts.getRawParameterValue("dumpRetentionSize");
+    std::atomic<float> *dumpRetentionAgeParam = apvts.getRawParameterValue("dumpRetentionAge");
+    std::atomic<float> *dumpRetentionFilesParam = apvts.getRawParameterValue("dumpRetentionFiles");
     int pluginType = -1;
     std::string hostAppName = "";
     int hostAppVersion = -1;
-    bool bypassEnable = false;
-    bool dataDumpEnable = false;
     bool isLicenseValid = false;
     bool isInitDone = false;
     bool toReleaseResources = false;
@@ -106,20 +163,53 @@ private:
     uint64_t processBlockCounter = 0;
     uint64_t algoFrameCounter = 0;
 
-    const int blockSize = 2048;
+    static constexpr int kMaxBlockSize = 4096;
+    int blockSize = 2048; // internal frame size, 0 processes the host buffer in place with no added latency
     void *algo_handle = nullptr;
-    float gain = 0.0f;
+    float appliedGain = 0.0f; // gain last handed to algo_set_param, only touched by the audio thread
+    float queuedGain = 0.0f;  // gain of the newest queued event
+    GainEvent gainEvents[kMaxGainEvents];
+    int numGainEvents = 0;
 
     std::unique_ptr<float[]> writeBuf[MAX_SUPPORT_CHANNELS];
     std::unique_ptr<float[]> readBuf[MAX_SUPPORT_CHANNELS];
+    std::unique_ptr<double[]> writeBufDouble[MAX_SUPPORT_CHANNELS];
+    std::unique_ptr<double[]> readBufDouble[MAX_SUPPORT_CHANNELS];
     int writeIndex = 0;
     int readIndex = 0;
-    juce::File dataDumpDir, dataDumpFile;
-    FILE *dataDumpFilePtr = nullptr;
+    bool fifoIsDouble = false; // precision of the FIFO the indices above belong to
+    juce::File dataDumpDir;
+    myDumpWriter dataDumpWriter;
+    int dumpTapStreams[NumDumpTaps] = {-1, -1, -1, -1}; // dataDumpWriter stream of each tap, -1 when the tap is off
+    int dumpMetaStream = -1;                            // frame sidecar of the taps, -1 when no tap is on
+    uint8_t dumpMetaHeader[kDumpMetaFileHeaderBytes] = {0};
+    bool dumpMetaHeaderPending = false; // audio thread, the header goes in front of the first frame record
+    static constexpr double kFlightRecorderSeconds = 10.0;
+    myFlightRecorder flightRecorder;
+    juce::SharedResourcePointer<myDumpHousekeeper> dumpHousekeeper;
 
     double originalSampleRate = 0;
     int originalChannels = 0;
     int validChannels = 0;
 
+    template <typename SampleType>
+    void processBlockInternal(juce::AudioBuffer<SampleType> &buffer,
+                              std::unique_ptr<SampleType[]> (&writeBufs)[MAX_SUPPORT_CHANNELS],
+                              std::unique_ptr<SampleType[]> (&readBufs)[MAX_SUPPORT_CHANNELS]);
+    template <typename SampleType>
+    int processFrame(const SampleType *const *input, SampleType *const *output, int frameSize);
+    template <typename SampleType>
+    void runFrame(const SampleType *const *input, SampleType *const *output, int frameSize,
+                  const ParamSnapshot &params);
+    template <typename SampleType>
+    void copyFrame(const SampleType *const *input, SampleType *const *output, int numSamples) const
+    {
+        for (int channel = 0; channel < validChannels; channel++) {
+            if (output[channel] != input[channel]) {
+                std::memcpy(output[channel], input[channel], numSamples * sizeof(SampleType));
+            }
+        }
+    }
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DemoAudioProcessor)
 };
@@ -9,15 +9,22 @@
 #include "algo_example.h"
 #include "../myLogger.h"
 #include "gain_control.h"
+#include "gain_kernel.h"
 
 #define VERSION "0.1.2"
 #define MAX_BUF_SIZE 1024
+#define GAIN_RAMP_SAMPLES 480 // about 10 ms at 48 kHz
 
 typedef struct algo_handle {
     char param1;
     float param2;
     char param3[MAX_BUF_SIZE];
     float *param4;
+    gain_kernel_t gain_kernel;
+    float gain_current; // linear gain reached at the end of the last processed block
+    float gain_target;  // linear gain of param2, worked out once in algo_set_param
+    float gain_step;
+    int gain_ramp_remaining;
 } algo_handle_t, *p_algo_handle_t;
 
 static int validate_param_size(int received_size, int expected_size, const char *param_name)
@@ -49,7 +56,10 @@ void *algo_init()
         return NULL;
     }
     memset(algo_handle, 0, sizeof(algo_handle_t));
-    LOG_MSG_CF(LOG_INFO, "algo_init OK");
+    algo_handle->gain_kernel = gain_kernel_select();
+    algo_handle->gain_current = 1.0f;
+    algo_handle->gain_target = 1.0f;
+    LOG_MSG_CF(LOG_INFO, "algo_init OK, gain kernel: %s", gain_kernel_isa_name(algo_handle->gain_kernel.isa));
     return algo_handle;
 }
 
@@ -97,7 +107,11 @@ int algo_set_param(void *algo_handle, algo_param_t cmd, void *param, int param_s
         ret = validate_param_size(param_size, sizeof(float), "param2");
         if (ret == E_OK) {
             algo_handle_ptr->param2 = *(float *)param;
-            LOG_MSG_CF(LOG_INFO, "set param2: %.3f", algo_handle_ptr->param2);
+            algo_handle_ptr->gain_target = dBChangeToFactor(algo_handle_ptr->param2);
+            algo_handle_ptr->gain_step =
+                (algo_handle_ptr->gain_target - algo_handle_ptr->gain_current) / GAIN_RAMP_SAMPLES;
+            algo_handle_ptr->gain_ramp_remaining = GAIN_RAMP_SAMPLES;
+            LOG_RT_C(LOG_DEBUG, "set param2: %.3f", algo_handle_ptr->param2);
         }
         break;
     case ALGO_PARAM3:
@@ -123,6 +137,20 @@ int algo_set_param(void *algo_handle, algo_param_t cmd, void *param, int param_s
         }
         memcpy(algo_handle_ptr->param4, param, param_size);
         break;
+    case ALGO_PARAM_GAIN_RAMP:
+        ret = validate_param_size(param_size, sizeof(algo_gain_ramp_t), "gain ramp");
+        if (ret == E_OK) {
+            const algo_gain_ramp_t *ramp = (const algo_gain_ramp_t *)param;
+            if (ramp->remaining < 0) {
+                LOG_MSG_CF(LOG_ERROR, "gain ramp remaining is negative: %d", ramp->remaining);
+                return E_PARAM_OUT_OF_RANGE;
+            }
+            algo_handle_ptr->gain_current = ramp->current;
+            algo_handle_ptr->gain_target = ramp->target;
+            algo_handle_ptr->gain_step = ramp->step;
+            algo_handle_ptr->gain_ramp_remaining = ramp->remaining;
+        }
+        break;
     default:
         LOG_MSG_CF(LOG_ERROR, "cmd %d is invalid", cmd);
         return E_PARAM_OUT_OF_RANGE;
@@ -181,6 +209,17 @@ int algo_get_param(void *algo_handle, algo_param_t cmd, void *param, int param_s
         }
         memcpy(param, algo_handle_ptr->param4, param_size);
         break;
+    case ALGO_PARAM_GAIN_RAMP:
+        // no log, the audio thread reads it when a data dump starts
+        ret = validate_param_size(param_size, sizeof(algo_gain_ramp_t), "gain ramp");
+        if (ret == E_OK) {
+            algo_gain_ramp_t *ramp = (algo_gain_ramp_t *)param;
+            ramp->current = algo_handle_ptr->gain_current;
+            ramp->target = algo_handle_ptr->gain_target;
+            ramp->step = algo_handle_ptr->gain_step;
+            ramp->remaining = algo_handle_ptr->gain_ramp_remaining;
+        }
+        break;
     default:
         LOG_MSG_CF(LOG_ERROR, "cmd is invalid");
         return E_PARAM_OUT_OF_RANGE;
@@ -188,33 +227,14 @@ int algo_get_param(void *algo_handle, algo_param_t cmd, void *param, int param_s
     return ret;
 }
 
-int algo_process(void *algo_handle, const float *input, float *output, int block_size)
-{
-    if (algo_handle == NULL) {
-        return E_ALGO_HANDLE_NULL;
-    }
-    if (input == NULL) {
-        LOG_MSG_CF(LOG_ERROR, "input is NULL");
-        return E_PARAM_BUFFER_NULL;
-    }
-    if (output == NULL) {
-        LOG_MSG_CF(LOG_ERROR, "output is NULL");
-        return E_PARAM_BUFFER_NULL;
-    }
-    if (block_size <= 0) {
-        LOG_MSG_CF(LOG_ERROR, "block_size is not correct");
-        return E_PARAM_SIZE_INVALID;
-    }
-    p_algo_handle_t algo_handle_ptr = (p_algo_handle_t)algo_handle;
+#define ALGO_SAMPLE_T float
+#define ALGO_NAME(name) name
+#define ALGO_KERNEL_APPLY apply
+#define ALGO_KERNEL_APPLY_RAMP apply_ramp
+#include "algo_process_impl.h"
 
-    if (algo_handle_ptr->param2 == 0.0f) {
-        memcpy(output, input, block_size * sizeof(float));
-        return E_OK;
-    }
-
-    for (int i = 0; i < block_size; i++) {
-        output[i] = input[i] * dBChangeToFactor(algo_handle_ptr->param2);
-    }
-
-    return E_OK;
-}
+#define ALGO_SAMPLE_T double
+#define ALGO_NAME(name) name##_double
+#define ALGO_KERNEL_APPLY apply_double
+#define ALGO_KERNEL_APPLY_RAMP apply_ramp_double
+#include "algo_process_impl.h"
@@ -29,14 +29,31 @@ typedef enum algo_param {
     ALGO_PARAM2,
     ALGO_PARAM3,
     ALGO_PARAM4,
+    ALGO_PARAM_GAIN_RAMP, // algo_gain_ramp_t, lets a replay start from the gain state of a recorded session
     ALGO_PARAM_END,
 } algo_param_t;
 
+// Gain state between two blocks. Setting it leaves param2 alone, set that first if it has to match as well.
+typedef struct algo_gain_ramp {
+    float current; // linear gain reached at the end of the last processed block
+    float target;  // linear gain the ramp ends at
+    float step;    // gain change per sample while the ramp lasts
+    int remaining; // samples left in the ramp, 0 once the target is reached
+} algo_gain_ramp_t;
+
 int get_algo_version(char *version);
 void *algo_init();
 void algo_deinit(void *algo_handle);
 int algo_set_param(void *algo_handle, algo_param_t cmd, void *param, int param_size);
 int algo_get_param(void *algo_handle, algo_param_t cmd, void *param, int param_size);
 int algo_process(void *algo_handle, const float *input, float *output, int block_size);
+// Planar multichannel variant: input[c] and output[c] hold block_size samples of channel c, in place is allowed.
+// Every channel sees the same gain curve, unlike calling algo_process once per channel.
+int algo_process_multi(void *algo_handle, const float *const *input, float *const *output, int num_channels,
+                       int block_size);
+// Double precision variants, same gain state and ramp as the float ones
+int algo_process_double(void *algo_handle, const double *input, double *output, int block_size);
+int algo_process_multi_double(void *algo_handle, const double *const *input, double *const *output,
+                              int num_channels, int block_size);
 
 #endif
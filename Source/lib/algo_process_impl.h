@@ -0,0 +1,111 @@
+/***************************************************************************
+ * Description: Sample type independent part of algo_example
+ * version: 0.1.0
+ * Author: Panda-Young
+ * Date: 2026-10-17 23:05:18
+ * Copyright (c) 2024 by Panda-Young, All Rights Reserved.
+ **************************************************************************/
+
+// Included by algo_example.c once per sample type, so the float and double paths share one body.
+// Before each inclusion it defines:
+//   ALGO_SAMPLE_T           float or double
+//   ALGO_NAME(name)         the name of a function for that type, e.g. name or name##_double
+//   ALGO_KERNEL_APPLY       the gain_kernel_t member that applies a constant gain to that type
+//   ALGO_KERNEL_APPLY_RAMP  the gain_kernel_t member that applies a gain ramp to that type
+// and this file undefines them again. There is deliberately no include guard.
+
+// All channels share one gain state, so the ramp advances once per block and not once per channel
+static void ALGO_NAME(process_gain)(p_algo_handle_t algo_handle_ptr, const ALGO_SAMPLE_T *const *input,
+                                    ALGO_SAMPLE_T *const *output, int num_channels, int block_size)
+{
+    int ramp_size = 0;
+    if (algo_handle_ptr->gain_ramp_remaining > 0) {
+        ramp_size = block_size;
+        if (ramp_size > algo_handle_ptr->gain_ramp_remaining) {
+            ramp_size = algo_handle_ptr->gain_ramp_remaining;
+        }
+        for (int channel = 0; channel < num_channels; channel++) {
+            algo_handle_ptr->gain_kernel.ALGO_KERNEL_APPLY_RAMP(input[channel], output[channel], ramp_size,
+                                                                algo_handle_ptr->gain_current,
+                                                                algo_handle_ptr->gain_step);
+        }
+        algo_handle_ptr->gain_ramp_remaining -= ramp_size;
+        if (algo_handle_ptr->gain_ramp_remaining == 0) {
+            algo_handle_ptr->gain_current = algo_handle_ptr->gain_target;
+        } else {
+            algo_handle_ptr->gain_current += algo_handle_ptr->gain_step * (float)ramp_size;
+        }
+        if (ramp_size == block_size) {
+            return;
+        }
+    }
+
+    int remain = block_size - ramp_size;
+    for (int channel = 0; channel < num_channels; channel++) {
+        const ALGO_SAMPLE_T *in = input[channel] + ramp_size;
+        ALGO_SAMPLE_T *out = output[channel] + ramp_size;
+        if (algo_handle_ptr->gain_current == 1.0f) {
+            if (out != in) {
+                memcpy(out, in, remain * sizeof(ALGO_SAMPLE_T));
+            }
+        } else {
+            algo_handle_ptr->gain_kernel.ALGO_KERNEL_APPLY(in, out, remain, algo_handle_ptr->gain_current);
+        }
+    }
+}
+
+int ALGO_NAME(algo_process)(void *algo_handle, const ALGO_SAMPLE_T *input, ALGO_SAMPLE_T *output, int block_size)
+{
+    if (algo_handle == NULL) {
+        return E_ALGO_HANDLE_NULL;
+    }
+    if (input == NULL) {
+        LOG_RT_C(LOG_ERROR, "input is NULL");
+        return E_PARAM_BUFFER_NULL;
+    }
+    if (output == NULL) {
+        LOG_RT_C(LOG_ERROR, "output is NULL");
+        return E_PARAM_BUFFER_NULL;
+    }
+    if (block_size <= 0) {
+        LOG_RT_C(LOG_ERROR, "block_size is not correct");
+        return E_PARAM_SIZE_INVALID;
+    }
+
+    ALGO_NAME(process_gain)((p_algo_handle_t)algo_handle, &input, &output, 1, block_size);
+    return E_OK;
+}
+
+int ALGO_NAME(algo_process_multi)(void *algo_handle, const ALGO_SAMPLE_T *const *input, ALGO_SAMPLE_T *const *output,
+                                  int num_channels, int block_size)
+{
+    if (algo_handle == NULL) {
+        return E_ALGO_HANDLE_NULL;
+    }
+    if (input == NULL || output == NULL) {
+        LOG_RT_C(LOG_ERROR, "channel array is NULL");
+        return E_PARAM_BUFFER_NULL;
+    }
+    if (num_channels <= 0) {
+        LOG_RT_C(LOG_ERROR, "num_channels is not correct: %d", num_channels);
+        return E_PARAM_SIZE_INVALID;
+    }
+    if (block_size <= 0) {
+        LOG_RT_C(LOG_ERROR, "block_size is not correct");
+        return E_PARAM_SIZE_INVALID;
+    }
+    for (int channel = 0; channel < num_channels; channel++) {
+        if (input[channel] == NULL || output[channel] == NULL) {
+            LOG_RT_C(LOG_ERROR, "buffer of channel %d is NULL", channel);
+            return E_PARAM_BUFFER_NULL;
+        }
+    }
+
+    ALGO_NAME(process_gain)((p_algo_handle_t)algo_handle, input, output, num_channels, block_size);
+    return E_OK;
+}
+
+#undef ALGO_SAMPLE_T
+#undef ALGO_NAME
+#undef ALGO_KERNEL_APPLY
+#undef ALGO_KERNEL_APPLY_RAMP
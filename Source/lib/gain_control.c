@@ -20,7 +20,7 @@ float dBChangeToFactor(float dBChange)
 {
     // Check the validity of dBChange
     if (isnan(dBChange) || isinf(dBChange)) {
-        LOG_MSG_CF(LOG_ERROR, "Invalid dBChange value: %f, returning default value: 1.0", dBChange);
+        LOG_RT_C(LOG_ERROR, "Invalid dBChange value: %f, returning default value: 1.0", dBChange);
         // If dBChange is NaN or infinite, return an error value or a default value
         // Alternatively, one could choose to return MIN_GAIN_FACTOR or MAX_GAIN_FACTOR, depending on the requirement
         return 1.0f;
@@ -0,0 +1,628 @@
+/***************************************************************************
+ * Description: Gain kernels with runtime SIMD dispatch
+ * version: 0.1.0
+ * Author: Panda-Young
+ * Date: 2026-10-17 10:12:41
+ * Copyright (c) 2024 by Panda-Young, All Rights Reserved.
+ **************************************************************************/
+
+#include "gain_kernel.h"
+#include "../myLogger.h"
+#include <stdint.h>
+#include <string.h>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define GAIN_KERNEL_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#define GAIN_KERNEL_ARM_NEON 1
+#include <arm_neon.h>
+#endif
+
+// GCC and Clang need the ISA enabled per function, MSVC accepts the intrinsics anywhere
+#if defined(__GNUC__) || defined(__clang__)
+#define GAIN_TARGET(isa) __attribute__((target(isa)))
+#else
+#define GAIN_TARGET(isa)
+#endif
+
+// Keep a * b + c as two roundings so the vector ramps match the scalar reference bit for bit
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+#define SELF_TEST_SIZE 1027 // not a multiple of any vector width, so the tails are covered too
+
+static void gain_apply_scalar(const float *input, float *output, int block_size, float factor)
+{
+    for (int i = 0; i < block_size; i++) {
+        output[i] = input[i] * factor;
+    }
+}
+
+static void gain_ramp_scalar(const float *input, float *output, int block_size, float start, float step)
+{
+    for (int i = 0; i < block_size; i++) {
+        output[i] = input[i] * (start + step * (float)(i + 1));
+    }
+}
+
+static void gain_apply_scalar_double(const double *input, double *output, int block_size, double factor)
+{
+    for (int i = 0; i < block_size; i++) {
+        output[i] = input[i] * factor;
+    }
+}
+
+static void gain_ramp_scalar_double(const double *input, double *output, int block_size, double start, double step)
+{
+    for (int i = 0; i < block_size; i++) {
+        output[i] = input[i] * (start + step * (double)(i + 1));
+    }
+}
+
+#if GAIN_KERNEL_X86
+GAIN_TARGET("sse2")
+static void gain_apply_sse2(const float *input, float *output, int block_size, float factor)
+{
+    const __m128 f = _mm_set1_ps(factor);
+    int i = 0;
+    for (; i + 8 <= block_size; i += 8) {
+        __m128 a = _mm_loadu_ps(input + i);
+        __m128 b = _mm_loadu_ps(input + i + 4);
+        _mm_storeu_ps(output + i, _mm_mul_ps(a, f));
+        _mm_storeu_ps(output + i + 4, _mm_mul_ps(b, f));
+    }
+    for (; i + 4 <= block_size; i += 4) {
+        _mm_storeu_ps(output + i, _mm_mul_ps(_mm_loadu_ps(input + i), f));
+    }
+    for (; i < block_size; i++) {
+        output[i] = input[i] * factor;
+    }
+}
+
+GAIN_TARGET("sse2")
+static void gain_ramp_sse2(const float *input, float *output, int block_size, float start, float step)
+{
+    const __m128 s0 = _mm_set1_ps(start);
+    const __m128 st = _mm_set1_ps(step);
+    __m128i idx = _mm_setr_epi32(1, 2, 3, 4);
+    const __m128i inc = _mm_set1_epi32(4);
+    int i = 0;
+    for (; i + 4 <= block_size; i += 4) {
+        __m128 g = _mm_add_ps(s0, _mm_mul_ps(st, _mm_cvtepi32_ps(idx)));
+        _mm_storeu_ps(output + i, _mm_mul_ps(_mm_loadu_ps(input + i), g));
+        idx = _mm_add_epi32(idx, inc);
+    }
+    for (; i < block_size; i++) {
+        output[i] = input[i] * (start + step * (float)(i + 1));
+    }
+}
+
+GAIN_TARGET("sse2")
+static void gain_apply_sse2_double(const double *input, double *output, int block_size, double factor)
+{
+    const __m128d f = _mm_set1_pd(factor);
+    int i = 0;
+    for (; i + 2 <= block_size; i += 2) {
+        _mm_storeu_pd(output + i, _mm_mul_pd(_mm_loadu_pd(input + i), f));
+    }
+    for (; i < block_size; i++) {
+        output[i] = input[i] * factor;
+    }
+}
+
+GAIN_TARGET("sse2")
+static void gain_ramp_sse2_double(const double *input, double *output, int block_size, double start, double step)
+{
+    const __m128d s0 = _mm_set1_pd(start);
+    const __m128d st = _mm_set1_pd(step);
+    const __m128d inc = _mm_set1_pd(2.0);
+    __m128d idx = _mm_setr_pd(1.0, 2.0); // integers stay exact in double, no int conversion needed
+    int i = 0;
+    for (; i + 2 <= block_size; i += 2) {
+        __m128d g = _mm_add_pd(s0, _mm_mul_pd(st, idx));
+        _mm_storeu_pd(output + i, _mm_mul_pd(_mm_loadu_pd(input + i), g));
+        idx = _mm_add_pd(idx, inc);
+    }
+    for (; i < block_size; i++) {
+        output[i] = input[i] * (start + step * (double)(i + 1));
+    }
+}
+
+GAIN_TARGET("avx2")
+static void gain_apply_avx2(const float *input, float *output, int block_size, float factor)
+{
+    const __m256 f = _mm256_set1_ps(factor);
+    int i = 0;
+    for (; i + 16 <= block_size; i += 16) {
+        __m256 a = _mm256_loadu_ps(input + i);
+        __m256 b = _mm256_loadu_ps(input + i + 8);
+        _mm256_storeu_ps(output + i, _mm256_mul_ps(a, f));
+        _mm256_storeu_ps(output + i + 8, _mm256_mul_ps(b, f));
+    }
+    for (; i + 8 <= block_size; i += 8) {
+        _mm256_storeu_ps(output + i, _mm256_mul_ps(_mm256_loadu_ps(input + i), f));
+    }
+    for (; i < block_size; i++) {
+        output[i] = input[i] * factor;
+    }
+    _mm256_zeroupper();
+}
+
+GAIN_TARGET("avx2")
+static void gain_ramp_avx2(const float *input, float *output, int block_size, float start, float step)
+{
+    const __m256 s0 = _mm256_set1_ps(start);
+    const __m256 st = _mm256_set1_ps(step);
+    __m256i idx = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 8);
+    const __m256i inc = _mm256_set1_epi32(8);
+    int i = 0;
+    for (; i + 8 <= block_size; i += 8) {
+        __m256 g = _mm256_add_ps(s0, _mm256_mul_ps(st, _mm256_cvtepi32_ps(idx)));
+        _mm256_storeu_ps(output + i, _mm256_mul_ps(_mm256_loadu_ps(input + i), g));
+        idx = _mm256_add_epi32(idx, inc);
+    }
+    for (; i < block_size; i++) {
+        output[i] = input[i] * (start + step * (float)(i + 1));
+    }
+    _mm256_zeroupper();
+}
+
+GAIN_TARGET("avx2")
+static void gain_apply_avx2_double(const double *input, double *output, int block_size, double factor)
+{
+    const __m256d f = _mm256_set1_pd(factor);
+    int i = 0;
+    for (; i + 4 <= block_size; i += 4) {
+        _mm256_storeu_pd(output + i, _mm256_mul_pd(_mm256_loadu_pd(input + i), f));
+    }
+    for (; i < block_size; i++) {
+        output[i] = input[i] * factor;
+    }
+    _mm256_zeroupper();
+}
+
+GAIN_TARGET("avx2")
+static void gain_ramp_avx2_double(const double *input, double *output, int block_size, double start, double step)
+{
+    const __m256d s0 = _mm256_set1_pd(start);
+    const __m256d st = _mm256_set1_pd(step);
+    const __m256d inc = _mm256_set1_pd(4.0);
+    __m256d idx = _mm256_setr_pd(1.0, 2.0, 3.0, 4.0);
+    int i = 0;
+    for (; i + 4 <= block_size; i += 4) {
+        __m256d g = _mm256_add_pd(s0, _mm256_mul_pd(st, idx));
+        _mm256_storeu_pd(output + i, _mm256_mul_pd(_mm256_loadu_pd(input + i), g));
+        idx = _mm256_add_pd(idx, inc);
+    }
+    for (; i < block_size; i++) {
+        output[i] = input[i] * (start + step * (double)(i + 1));
+    }
+    _mm256_zeroupper();
+}
+
+GAIN_TARGET("avx512f")
+static void gain_apply_avx512(const float *input, float *output, int block_size, float factor)
+{
+    const __m512 f = _mm512_set1_ps(factor);
+    int i = 0;
+    for (; i + 32 <= block_size; i += 32) {
+        __m512 a = _mm512_loadu_ps(input + i);
+        __m512 b = _mm512_loadu_ps(input + i + 16);
+        _mm512_storeu_ps(output + i, _mm512_mul_ps(a, f));
+        _mm512_storeu_ps(output + i + 16, _mm512_mul_ps(b, f));
+    }
+    // masked tail instead of a scalar loop, at most 31 samples left
+    for (; i < block_size; i += 16) {
+        int remain = block_size - i;
+        __mmask16 mask = (__mmask16)(remain >= 16 ? 0xFFFF : ((1u << remain) - 1u));
+        __m512 a = _mm512_maskz_loadu_ps(mask, input + i);
+        _mm512_mask_storeu_ps(output + i, mask, _mm512_mul_ps(a, f));
+    }
+    _mm256_zeroupper();
+}
+
+GAIN_TARGET("avx512f")
+static void gain_ramp_avx512(const float *input, float *output, int block_size, float start, float step)
+{
+    const __m512 s0 = _mm512_set1_ps(start);
+    const __m512 st = _mm512_set1_ps(step);
+    __m512i idx = _mm512_setr_epi32(1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16);
+    const __m512i inc = _mm512_set1_epi32(16);
+    for (int i = 0; i < block_size; i += 16) {
+        int remain = block_size - i;
+        __mmask16 mask = (__mmask16)(remain >= 16 ? 0xFFFF : ((1u << remain) - 1u));
+        __m512 g = _mm512_add_ps(s0, _mm512_mul_ps(st, _mm512_cvtepi32_ps(idx)));
+        __m512 a = _mm512_maskz_loadu_ps(mask, input + i);
+        _mm512_mask_storeu_ps(output + i, mask, _mm512_mul_ps(a, g));
+        idx = _mm512_add_epi32(idx, inc);
+    }
+    _mm256_zeroupper();
+}
+
+GAIN_TARGET("avx512f")
+static void gain_apply_avx512_double(const double *input, double *output, int block_size, double factor)
+{
+    const __m512d f = _mm512_set1_pd(factor);
+    for (int i = 0; i < block_size; i += 8) {
+        int remain = block_size - i;
+        __mmask8 mask = (__mmask8)(remain >= 8 ? 0xFF : ((1u << remain) - 1u));
+        __m512d a = _mm512_maskz_loadu_pd(mask, input + i);
+        _mm512_mask_storeu_pd(output + i, mask, _mm512_mul_pd(a, f));
+    }
+    _mm256_zeroupper();
+}
+
+GAIN_TARGET("avx512f")
+static void gain_ramp_avx512_double(const double *input, double *output, int block_size, double start, double step)
+{
+    const __m512d s0 = _mm512_set1_pd(start);
+    const __m512d st = _mm512_set1_pd(step);
+    const __m512d inc = _mm512_set1_pd(8.0);
+    __m512d idx = _mm512_setr_pd(1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0);
+    for (int i = 0; i < block_size; i += 8) {
+        int remain = block_size - i;
+        __mmask8 mask = (__mmask8)(remain >= 8 ? 0xFF : ((1u << remain) - 1u));
+        __m512d g = _mm512_add_pd(s0, _mm512_mul_pd(st, idx));
+        __m512d a = _mm512_maskz_loadu_pd(mask, input + i);
+        _mm512_mask_storeu_pd(output + i, mask, _mm512_mul_pd(a, g));
+        idx = _mm512_add_pd(idx, inc);
+    }
+    _mm256_zeroupper();
+}
+
+static void cpuid_query(int leaf, int subleaf, unsigned int regs[4])
+{
+#if defined(_MSC_VER)
+    int info[4] = {0};
+    __cpuidex(info, leaf, subleaf);
+    for (int i = 0; i < 4; i++) {
+        regs[i] = (unsigned int)info[i];
+    }
+#else
+    unsigned int a = 0, b = 0, c = 0, d = 0;
+    __cpuid_count(leaf, subleaf, a, b, c, d);
+    regs[0] = a;
+    regs[1] = b;
+    regs[2] = c;
+    regs[3] = d;
+#endif
+}
+
+static uint64_t xgetbv_query(void)
+{
+#if defined(_MSC_VER)
+    return (uint64_t)_xgetbv(0);
+#else
+    unsigned int lo = 0, hi = 0;
+    __asm__ __volatile__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return ((uint64_t)hi << 32) | lo;
+#endif
+}
+
+static gain_kernel_isa_t detect_best_isa(void)
+{
+    unsigned int regs[4] = {0};
+    cpuid_query(0, 0, regs);
+    unsigned int max_leaf = regs[0];
+    if (max_leaf < 1) {
+        return GAIN_KERNEL_SCALAR;
+    }
+
+    cpuid_query(1, 0, regs);
+    int has_sse2 = (regs[3] >> 26) & 1;
+    int has_osxsave = (regs[2] >> 27) & 1;
+    int has_avx = (regs[2] >> 28) & 1;
+    if (!has_sse2) {
+        return GAIN_KERNEL_SCALAR;
+    }
+    if (!has_osxsave || !has_avx || max_leaf < 7) {
+        return GAIN_KERNEL_SSE2;
+    }
+
+    // The OS must save the YMM (and ZMM) state on context switch
+    uint64_t xcr0 = xgetbv_query();
+    int os_ymm = (xcr0 & 0x6) == 0x6;
+    int os_zmm = (xcr0 & 0xE6) == 0xE6;
+
+    cpuid_query(7, 0, regs);
+    int has_avx2 = (regs[1] >> 5) & 1;
+    int has_avx512f = (regs[1] >> 16) & 1;
+
+    if (has_avx512f && os_zmm) {
+        return GAIN_KERNEL_AVX512;
+    }
+    if (has_avx2 && os_ymm) {
+        return GAIN_KERNEL_AVX2;
+    }
+    return GAIN_KERNEL_SSE2;
+}
+#endif // GAIN_KERNEL_X86
+
+#if GAIN_KERNEL_ARM_NEON
+static void gain_apply_neon(const float *input, float *output, int block_size, float factor)
+{
+    const float32x4_t f = vdupq_n_f32(factor);
+    int i = 0;
+    for (; i + 8 <= block_size; i += 8) {
+        float32x4_t a = vld1q_f32(input + i);
+        float32x4_t b = vld1q_f32(input + i + 4);
+        vst1q_f32(output + i, vmulq_f32(a, f));
+        vst1q_f32(output + i + 4, vmulq_f32(b, f));
+    }
+    for (; i + 4 <= block_size; i += 4) {
+        vst1q_f32(output + i, vmulq_f32(vld1q_f32(input + i), f));
+    }
+    for (; i < block_size; i++) {
+        output[i] = input[i] * factor;
+    }
+}
+
+static void gain_ramp_neon(const float *input, float *output, int block_size, float start, float step)
+{
+    static const int32_t first[4] = {1, 2, 3, 4};
+    const float32x4_t s0 = vdupq_n_f32(start);
+    const float32x4_t st = vdupq_n_f32(step);
+    int32x4_t idx = vld1q_s32(first);
+    const int32x4_t inc = vdupq_n_s32(4);
+    int i = 0;
+    for (; i + 4 <= block_size; i += 4) {
+        // vmulq + vaddq rather than vmlaq/vfmaq, the scalar reference rounds twice
+        float32x4_t g = vaddq_f32(s0, vmulq_f32(st, vcvtq_f32_s32(idx)));
+        vst1q_f32(output + i, vmulq_f32(vld1q_f32(input + i), g));
+        idx = vaddq_s32(idx, inc);
+    }
+    for (; i < block_size; i++) {
+        output[i] = input[i] * (start + step * (float)(i + 1));
+    }
+}
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+static void gain_apply_neon_double(const double *input, double *output, int block_size, double factor)
+{
+    const float64x2_t f = vdupq_n_f64(factor);
+    int i = 0;
+    for (; i + 2 <= block_size; i += 2) {
+        vst1q_f64(output + i, vmulq_f64(vld1q_f64(input + i), f));
+    }
+    for (; i < block_size; i++) {
+        output[i] = input[i] * factor;
+    }
+}
+
+static void gain_ramp_neon_double(const double *input, double *output, int block_size, double start, double step)
+{
+    static const double first[2] = {1.0, 2.0};
+    const float64x2_t s0 = vdupq_n_f64(start);
+    const float64x2_t st = vdupq_n_f64(step);
+    const float64x2_t inc = vdupq_n_f64(2.0);
+    float64x2_t idx = vld1q_f64(first);
+    int i = 0;
+    for (; i + 2 <= block_size; i += 2) {
+        float64x2_t g = vaddq_f64(s0, vmulq_f64(st, idx));
+        vst1q_f64(output + i, vmulq_f64(vld1q_f64(input + i), g));
+        idx = vaddq_f64(idx, inc);
+    }
+    for (; i < block_size; i++) {
+        output[i] = input[i] * (start + step * (double)(i + 1));
+    }
+}
+#else
+// 32-bit NEON has no double lanes
+#define gain_apply_neon_double gain_apply_scalar_double
+#define gain_ramp_neon_double gain_ramp_scalar_double
+#endif
+
+static gain_kernel_isa_t detect_best_isa(void)
+{
+    // NEON is mandatory on AArch64 and was enabled at compile time on 32-bit ARM
+    return GAIN_KERNEL_NEON;
+}
+#endif // GAIN_KERNEL_ARM_NEON
+
+#if !GAIN_KERNEL_X86 && !GAIN_KERNEL_ARM_NEON
+static gain_kernel_isa_t detect_best_isa(void)
+{
+    return GAIN_KERNEL_SCALAR;
+}
+#endif
+
+static gain_kernel_t make_kernel(gain_kernel_isa_t isa)
+{
+    gain_kernel_t kernel = {GAIN_KERNEL_SCALAR, gain_apply_scalar, gain_ramp_scalar,
+                            gain_apply_scalar_double, gain_ramp_scalar_double};
+    switch (isa) {
+#if GAIN_KERNEL_X86
+    case GAIN_KERNEL_SSE2:
+        kernel.isa = isa;
+        kernel.apply = gain_apply_sse2;
+        kernel.apply_ramp = gain_ramp_sse2;
+        kernel.apply_double = gain_apply_sse2_double;
+        kernel.apply_ramp_double = gain_ramp_sse2_double;
+        break;
+    case GAIN_KERNEL_AVX2:
+        kernel.isa = isa;
+        kernel.apply = gain_apply_avx2;
+        kernel.apply_ramp = gain_ramp_avx2;
+        kernel.apply_double = gain_apply_avx2_double;
+        kernel.apply_ramp_double = gain_ramp_avx2_double;
+        break;
+    case GAIN_KERNEL_AVX512:
+        kernel.isa = isa;
+        kernel.apply = gain_apply_avx512;
+        kernel.apply_ramp = gain_ramp_avx512;
+        kernel.apply_double = gain_apply_avx512_double;
+        kernel.apply_ramp_double = gain_ramp_avx512_double;
+        break;
+#endif
+#if GAIN_KERNEL_ARM_NEON
+    case GAIN_KERNEL_NEON:
+        kernel.isa = isa;
+        kernel.apply = gain_apply_neon;
+        kernel.apply_ramp = gain_ramp_neon;
+        kernel.apply_double = gain_apply_neon_double;
+        kernel.apply_ramp_double = gain_ramp_neon_double;
+        break;
+#endif
+    default:
+        break;
+    }
+    return kernel;
+}
+
+const char *gain_kernel_isa_name(gain_kernel_isa_t isa)
+{
+    switch (isa) {
+    case GAIN_KERNEL_SCALAR:
+        return "scalar";
+    case GAIN_KERNEL_SSE2:
+        return "SSE2";
+    case GAIN_KERNEL_AVX2:
+        return "AVX2";
+    case GAIN_KERNEL_AVX512:
+        return "AVX-512";
+    case GAIN_KERNEL_NEON:
+        return "NEON";
+    default:
+        return "unknown";
+    }
+}
+
+gain_kernel_t gain_kernel_get(gain_kernel_isa_t isa)
+{
+    // Every x86 level implies the ones below it, and make_kernel() falls back to scalar
+    // for any ISA that is not compiled in for this architecture
+    if (isa > detect_best_isa()) {
+        isa = GAIN_KERNEL_SCALAR;
+    }
+    return make_kernel(isa);
+}
+
+static const float self_test_factors[] = {0.0f, 0.1f, 0.5011872f, 1.0f, 3.1622777f, 10.0f, 10000.0f};
+static const float self_test_steps[] = {0.0f, 1.0f / 512.0f, -0.0017583f, 9.765625f};
+#define SELF_TEST_NUM_FACTORS (sizeof(self_test_factors) / sizeof(self_test_factors[0]))
+#define SELF_TEST_NUM_STEPS (sizeof(self_test_steps) / sizeof(self_test_steps[0]))
+
+static int self_test_double(gain_kernel_t kernel, const float *input_float)
+{
+    double input[SELF_TEST_SIZE];
+    double expected[SELF_TEST_SIZE];
+    double actual[SELF_TEST_SIZE];
+    for (int i = 0; i < SELF_TEST_SIZE; i++) {
+        input[i] = (double)input_float[i] * (1.0 + 1.0e-9); // use bits a float cannot hold
+    }
+
+    for (size_t f = 0; f < SELF_TEST_NUM_FACTORS; f++) {
+        for (int len = 1; len <= SELF_TEST_SIZE; len += (len < 80 ? 1 : 97)) {
+            gain_apply_scalar_double(input, expected, len, self_test_factors[f]);
+            kernel.apply_double(input, actual, len, self_test_factors[f]);
+            if (memcmp(expected, actual, len * sizeof(double)) != 0) {
+                return -1;
+            }
+            for (size_t r = 0; r < SELF_TEST_NUM_STEPS; r++) {
+                gain_ramp_scalar_double(input, expected, len, self_test_factors[f], self_test_steps[r]);
+                kernel.apply_ramp_double(input, actual, len, self_test_factors[f], self_test_steps[r]);
+                if (memcmp(expected, actual, len * sizeof(double)) != 0) {
+                    return -1;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+int gain_kernel_self_test(gain_kernel_t kernel)
+{
+    const float *factors = self_test_factors;
+    const float *steps = self_test_steps;
+    float input[SELF_TEST_SIZE];
+    float expected[SELF_TEST_SIZE];
+    float actual[SELF_TEST_SIZE];
+
+    uint32_t seed = 0x12345678u;
+    for (int i = 0; i < SELF_TEST_SIZE; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        input[i] = (float)((int32_t)seed) / 2147483648.0f;
+    }
+    // denormals and signed zeros must survive the vector path as well
+    input[0] = 0.0f;
+    input[1] = -0.0f;
+    input[2] = 1.0e-40f;
+    input[3] = -1.0f;
+
+    for (size_t f = 0; f < SELF_TEST_NUM_FACTORS; f++) {
+        // every length up to a few vectors exercises the main loop and each tail path
+        for (int len = 1; len <= SELF_TEST_SIZE; len += (len < 80 ? 1 : 97)) {
+            gain_apply_scalar(input, expected, len, factors[f]);
+            kernel.apply(input, actual, len, factors[f]);
+            if (memcmp(expected, actual, len * sizeof(float)) != 0) {
+                return -1;
+            }
+            // in place
+            memcpy(actual, input, len * sizeof(float));
+            kernel.apply(actual, actual, len, factors[f]);
+            if (memcmp(expected, actual, len * sizeof(float)) != 0) {
+                return -1;
+            }
+            for (size_t r = 0; r < SELF_TEST_NUM_STEPS; r++) {
+                gain_ramp_scalar(input, expected, len, factors[f], steps[r]);
+                kernel.apply_ramp(input, actual, len, factors[f], steps[r]);
+                if (memcmp(expected, actual, len * sizeof(float)) != 0) {
+                    return -1;
+                }
+            }
+        }
+    }
+    return self_test_double(kernel, input);
+}
+
+static gain_kernel_t selected_kernel;
+
+static void select_kernel_once(void)
+{
+    gain_kernel_t kernel = make_kernel(detect_best_isa());
+    if (kernel.isa != GAIN_KERNEL_SCALAR && gain_kernel_self_test(kernel) != 0) {
+        LOG_MSG_CF(LOG_ERROR, "%s gain kernel is not bit-exact with the scalar one, fall back to scalar",
+                   gain_kernel_isa_name(kernel.isa));
+        kernel = make_kernel(GAIN_KERNEL_SCALAR);
+    }
+    selected_kernel = kernel;
+}
+
+#if defined(_WIN32)
+static BOOL CALLBACK select_kernel_init_once(PINIT_ONCE once, PVOID parameter, PVOID *context)
+{
+    (void)once;
+    (void)parameter;
+    (void)context;
+    select_kernel_once();
+    return TRUE;
+}
+#endif
+
+gain_kernel_t gain_kernel_select(void)
+{
+    // The self test takes a few milliseconds and a large stack frame, so it runs once per process and every
+    // algo_init() after the first one gets the cached kernel
+#if defined(_WIN32)
+    static INIT_ONCE once = INIT_ONCE_STATIC_INIT;
+    InitOnceExecuteOnce(&once, select_kernel_init_once, NULL, NULL);
+#else
+    static pthread_once_t once = PTHREAD_ONCE_INIT;
+    pthread_once(&once, select_kernel_once);
+#endif
+    return selected_kernel;
+}
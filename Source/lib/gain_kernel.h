@@ -0,0 +1,44 @@
+/***************************************************************************
+ * Description: Gain kernels with runtime SIMD dispatch
+ * version: 0.1.0
+ * Author: Panda-Young
+ * Date: 2026-10-17 10:12:41
+ * Copyright (c) 2024 by Panda-Young, All Rights Reserved.
+ **************************************************************************/
+
+#ifndef _GAIN_KERNEL_H
+#define _GAIN_KERNEL_H
+
+typedef enum gain_kernel_isa {
+    GAIN_KERNEL_SCALAR = 0,
+    GAIN_KERNEL_SSE2,
+    GAIN_KERNEL_AVX2,
+    GAIN_KERNEL_AVX512,
+    GAIN_KERNEL_NEON,
+} gain_kernel_isa_t;
+
+// output[i] = input[i] * factor, input and output may be the same buffer
+typedef void (*gain_kernel_fn)(const float *input, float *output, int block_size, float factor);
+// output[i] = input[i] * (start + step * (i + 1)), a linear ramp that reaches start + step * block_size
+typedef void (*gain_ramp_fn)(const float *input, float *output, int block_size, float start, float step);
+typedef void (*gain_kernel_double_fn)(const double *input, double *output, int block_size, double factor);
+typedef void (*gain_ramp_double_fn)(const double *input, double *output, int block_size, double start, double step);
+
+typedef struct gain_kernel {
+    gain_kernel_isa_t isa;
+    gain_kernel_fn apply;
+    gain_ramp_fn apply_ramp;
+    gain_kernel_double_fn apply_double;
+    gain_ramp_double_fn apply_ramp_double;
+} gain_kernel_t;
+
+// Detects the CPU features and returns the fastest kernel that passes the self test. The selection runs once
+// per process, later calls return the same kernel.
+gain_kernel_t gain_kernel_select(void);
+// Returns the kernel for a given ISA, or the scalar kernel if it is not available on this CPU
+gain_kernel_t gain_kernel_get(gain_kernel_isa_t isa);
+// Compares the kernel against the scalar reference, returns 0 if the outputs are bit-exact
+int gain_kernel_self_test(gain_kernel_t kernel);
+const char *gain_kernel_isa_name(gain_kernel_isa_t isa);
+
+#endif // _GAIN_KERNEL_H
@@ -0,0 +1,454 @@
+/***************************************************************************
+ * Description: myBinLog
+ * version: 0.1.0
+ * Author: Panda-Young
+ * Date: 2026-10-17 22:41:12
+ * Copyright (c) 2024 by Panda-Young, All Rights Reserved.
+ **************************************************************************/
+
+#include "myBinLog.h"
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+
+enum BinLogRecordType : uint8_t {
+    kBinLogSession = 1,
+    kBinLogChunk,
+    kBinLogSite,
+    kBinLogThread,
+    kBinLogRt,
+    kBinLogText,
+    kBinLogNote,
+};
+
+static constexpr uint8_t kBinLogVersion = 1;
+
+static void putVarint(std::vector<uint8_t> &out, uint64_t value)
+{
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+static void putSigned(std::vector<uint8_t> &out, int64_t value)
+{
+    putVarint(out, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+static void putString(std::vector<uint8_t> &out, const char *text, size_t length)
+{
+    putVarint(out, length);
+    out.insert(out.end(), text, text + length);
+}
+
+static void putString(std::vector<uint8_t> &out, const char *text)
+{
+    putString(out, text != nullptr ? text : "", text != nullptr ? strlen(text) : 0);
+}
+
+static int64_t toMicros(std::chrono::system_clock::time_point timestamp)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(timestamp.time_since_epoch()).count();
+}
+
+void myBinLogWriter::open(const std::string &newPath, const std::string &newProcessId)
+{
+    close();
+    path = newPath;
+    processId = newProcessId;
+}
+
+void myBinLogWriter::beginChunk()
+{
+    if (!buffer.empty()) {
+        return;
+    }
+    if (!sessionStarted) {
+        lastMicros = toMicros(std::chrono::system_clock::now());
+        buffer.push_back(kBinLogSession);
+        buffer.insert(buffer.end(), {'P', 'B', 'L', '1', kBinLogVersion});
+        putString(buffer, processId.data(), processId.size());
+        putSigned(buffer, lastMicros);
+        sessionStarted = true;
+    } else {
+        buffer.push_back(kBinLogChunk);
+        putString(buffer, processId.data(), processId.size());
+    }
+}
+
+uint32_t myBinLogWriter::getThreadIndex(std::thread::id threadId)
+{
+    auto found = threads.find(threadId);
+    if (found != threads.end()) {
+        return found->second;
+    }
+    const uint32_t index = static_cast<uint32_t>(threads.size());
+    std::ostringstream stream;
+    stream << threadId;
+    const std::string id = stream.str();
+    buffer.push_back(kBinLogThread);
+    putVarint(buffer, index);
+    putString(buffer, id.data(), id.size());
+    threads.emplace(threadId, index);
+    return index;
+}
+
+void myBinLogWriter::writeEventHeader(uint8_t type, uint32_t site, std::thread::id threadId, int level,
+                                      std::chrono::system_clock::time_point timestamp)
+{
+    // the thread record has to come before the event that refers to it
+    const uint32_t thread = getThreadIndex(threadId);
+    const int64_t micros = toMicros(timestamp);
+    buffer.push_back(type);
+    putVarint(buffer, site);
+    putVarint(buffer, thread);
+    buffer.push_back(static_cast<uint8_t>(level));
+    // the queue and the realtime rings are drained one after the other, so the delta may be negative
+    putSigned(buffer, micros - lastMicros);
+    lastMicros = micros;
+}
+
+void myBinLogWriter::writeRtEvent(const void *siteKey, const char *file, const char *function, int line,
+                                  const char *format, std::thread::id threadId, int level,
+                                  std::chrono::system_clock::time_point timestamp, const myLogArg *args,
+                                  int numArgs)
+{
+    if (!isOpen()) {
+        return;
+    }
+    beginChunk();
+    uint32_t site;
+    auto found = rtSites.find(siteKey);
+    if (found != rtSites.end()) {
+        site = found->second;
+    } else {
+        site = numSites++;
+        file = file != nullptr ? file : "unknown_file";
+        const char *fileName = strrchr(file, '\\') ? strrchr(file, '\\') : strrchr(file, '/');
+        function = function != nullptr ? function : "unknown_function";
+        const char *functionName = strrchr(function, ':');
+        buffer.push_back(kBinLogSite);
+        putVarint(buffer, site);
+        putSigned(buffer, line);
+        putString(buffer, fileName != nullptr ? fileName + 1 : file);
+        putString(buffer, functionName != nullptr ? functionName + 1 : function);
+        putString(buffer, format);
+        rtSites.emplace(siteKey, site);
+    }
+
+    writeEventHeader(kBinLogRt, site, threadId, level, timestamp);
+    numArgs = numArgs < 0 ? 0 : (numArgs > 255 ? 255 : numArgs);
+    buffer.push_back(static_cast<uint8_t>(numArgs));
+    for (int i = 0; i < numArgs; i++) {
+        const myLogArg &arg = args[i];
+        buffer.push_back(arg.type);
+        switch (arg.type) {
+        case myLogArg::Int:
+            putSigned(buffer, arg.i);
+            break;
+        case myLogArg::Double: {
+            uint64_t bits;
+            std::memcpy(&bits, &arg.d, sizeof(bits));
+            for (int b = 0; b < 8; b++) {
+                buffer.push_back(static_cast<uint8_t>(bits >> (8 * b)));
+            }
+            break;
+        }
+        case myLogArg::Pointer:
+            putVarint(buffer, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(arg.p)));
+            break;
+        default:
+            putVarint(buffer, arg.u);
+            break;
+        }
+    }
+}
+
+void myBinLogWriter::writeTextEvent(const char *file, const char *function, int line, std::thread::id threadId,
+                                    int level, std::chrono::system_clock::time_point timestamp, const char *message,
+                                    size_t length)
+{
+    if (!isOpen()) {
+        return;
+    }
+    beginChunk();
+    uint32_t site;
+    const auto key = std::make_tuple(static_cast<const void *>(file), static_cast<const void *>(function), line);
+    auto found = textSites.find(key);
+    if (found != textSites.end()) {
+        site = found->second;
+    } else {
+        site = numSites++;
+        buffer.push_back(kBinLogSite);
+        putVarint(buffer, site);
+        putSigned(buffer, line);
+        putString(buffer, file);
+        putString(buffer, function);
+        putString(buffer, "");
+        textSites.emplace(key, site);
+    }
+
+    writeEventHeader(kBinLogText, site, threadId, level, timestamp);
+    putString(buffer, message, length);
+}
+
+void myBinLogWriter::writeNote(const std::string &text)
+{
+    if (!isOpen()) {
+        return;
+    }
+    beginChunk();
+    buffer.push_back(kBinLogNote);
+    putString(buffer, text.data(), text.size());
+}
+
+bool myBinLogWriter::flush()
+{
+    if (buffer.empty()) {
+        return true;
+    }
+    bool written = false;
+    FILE *file = fopen(path.c_str(), "ab");
+    if (file != nullptr) {
+        written = fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+        written = fclose(file) == 0 && written;
+    }
+    buffer.clear();
+    if (!written) {
+        // what was lost may have held site or thread records, start a new session with fresh tables
+        resetSession();
+    }
+    return written;
+}
+
+void myBinLogWriter::close()
+{
+    if (isOpen()) {
+        flush();
+    }
+    path.clear();
+    buffer.clear();
+    resetSession();
+}
+
+void myBinLogWriter::resetSession()
+{
+    sessionStarted = false;
+    numSites = 0;
+    rtSites.clear();
+    textSites.clear();
+    threads.clear();
+}
+
+bool myBinLogReader::open(const std::string &path)
+{
+    data.clear();
+    position = 0;
+    damaged = false;
+    sessions.clear();
+    current = nullptr;
+
+    FILE *file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    uint8_t chunk[64 * 1024];
+    size_t numRead;
+    while ((numRead = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        data.insert(data.end(), chunk, chunk + numRead);
+    }
+    fclose(file);
+    return data.size() >= 5 && data[0] == kBinLogSession && std::memcmp(data.data() + 1, "PBL1", 4) == 0;
+}
+
+bool myBinLogReader::readVarint(uint64_t &value)
+{
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (position >= data.size()) {
+            return false;
+        }
+        const uint8_t byte = data[position++];
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool myBinLogReader::readSigned(int64_t &value)
+{
+    uint64_t encoded;
+    if (!readVarint(encoded)) {
+        return false;
+    }
+    value = static_cast<int64_t>(encoded >> 1) ^ -static_cast<int64_t>(encoded & 1);
+    return true;
+}
+
+bool myBinLogReader::readString(std::string &value)
+{
+    uint64_t length;
+    if (!readVarint(length) || length > data.size() - position) {
+        return false;
+    }
+    value.assign(reinterpret_cast<const char *>(data.data() + position), static_cast<size_t>(length));
+    position += static_cast<size_t>(length);
+    return true;
+}
+
+bool myBinLogReader::readEvent(uint8_t type, Event &event)
+{
+    uint64_t site, thread;
+    int64_t delta;
+    if (current == nullptr || !readVarint(site) || !readVarint(thread) || position >= data.size()) {
+        return false;
+    }
+    event.level = data[position++];
+    if (!readSigned(delta) || site >= current->sites.size() || thread >= current->threads.size()) {
+        return false;
+    }
+    current->lastMicros += delta;
+    const Site &entry = current->sites[static_cast<size_t>(site)];
+    event.isNote = false;
+    event.timestamp = std::chrono::system_clock::time_point(
+        std::chrono::duration_cast<std::chrono::system_clock::duration>(
+            std::chrono::microseconds(current->lastMicros)));
+    event.processId = currentProcessId;
+    event.threadId = current->threads[static_cast<size_t>(thread)];
+    event.file = entry.file;
+    event.function = entry.function;
+    event.line = entry.line;
+    if (type == kBinLogText) {
+        return readString(event.text);
+    }
+
+    if (position >= data.size()) {
+        return false;
+    }
+    const int numArgs = data[position++];
+    for (int i = 0; i < numArgs; i++) {
+        if (position >= data.size()) {
+            return false;
+        }
+        const uint8_t argType = data[position++];
+        myLogArg &arg = args[i];
+        switch (argType) {
+        case myLogArg::Int:
+            arg.type = myLogArg::Int;
+            if (!readSigned(arg.i)) {
+                return false;
+            }
+            break;
+        case myLogArg::UInt:
+            arg.type = myLogArg::UInt;
+            if (!readVarint(arg.u)) {
+                return false;
+            }
+            break;
+        case myLogArg::Double: {
+            if (data.size() - position < 8) {
+                return false;
+            }
+            uint64_t bits = 0;
+            for (int b = 0; b < 8; b++) {
+                bits |= static_cast<uint64_t>(data[position++]) << (8 * b);
+            }
+            arg.type = myLogArg::Double;
+            std::memcpy(&arg.d, &bits, sizeof(bits));
+            break;
+        }
+        case myLogArg::Pointer: {
+            uint64_t address;
+            if (!readVarint(address)) {
+                return false;
+            }
+            arg.type = myLogArg::Pointer;
+            arg.p = reinterpret_cast<const void *>(static_cast<uintptr_t>(address));
+            break;
+        }
+        default:
+            return false;
+        }
+    }
+    expandLogFormat(entry.format.c_str(), args, numArgs, event.text);
+    return true;
+}
+
+bool myBinLogReader::next(Event &event)
+{
+    while (!damaged && position < data.size()) {
+        const uint8_t type = data[position++];
+        bool valid = false;
+        switch (type) {
+        case kBinLogSession: {
+            std::string processId;
+            int64_t startMicros;
+            valid = data.size() - position >= 5 && std::memcmp(data.data() + position, "PBL1", 4) == 0 &&
+                    data[position + 4] == kBinLogVersion;
+            position += 5;
+            valid = valid && readString(processId) && readSigned(startMicros);
+            if (valid) {
+                currentProcessId = processId;
+                current = &sessions[processId];
+                *current = Session();
+                current->lastMicros = startMicros;
+            }
+            break;
+        }
+        case kBinLogChunk: {
+            std::string processId;
+            valid = readString(processId);
+            if (valid) {
+                auto found = sessions.find(processId);
+                valid = found != sessions.end();
+                currentProcessId = processId;
+                current = valid ? &found->second : nullptr;
+            }
+            break;
+        }
+        case kBinLogSite: {
+            uint64_t index;
+            int64_t line;
+            Site site;
+            valid = current != nullptr && readVarint(index) && readSigned(line) && readString(site.file) &&
+                    readString(site.function) && readString(site.format) && index == current->sites.size();
+            if (valid) {
+                site.line = static_cast<int>(line);
+                current->sites.push_back(std::move(site));
+            }
+            break;
+        }
+        case kBinLogThread: {
+            uint64_t index;
+            std::string id;
+            valid = current != nullptr && readVarint(index) && readString(id) && index == current->threads.size();
+            if (valid) {
+                current->threads.push_back(std::move(id));
+            }
+            break;
+        }
+        case kBinLogRt:
+        case kBinLogText:
+            if (readEvent(type, event)) {
+                return true;
+            }
+            break;
+        case kBinLogNote:
+            if (readString(event.text)) {
+                event.isNote = true;
+                return true;
+            }
+            break;
+        default:
+            break;
+        }
+        if (!valid) {
+            damaged = true;
+        }
+    }
+    return false;
+}
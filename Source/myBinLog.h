@@ -0,0 +1,117 @@
+/***************************************************************************
+ * Description: Header of myBinLog
+ * version: 0.1.0
+ * Author: Panda-Young
+ * Date: 2026-10-17 22:41:12
+ * Copyright (c) 2024 by Panda-Young, All Rights Reserved.
+ **************************************************************************/
+
+#pragma once
+
+// Binary log (.binlog) of the logger's worker thread. A call site and a thread are written once, an event
+// only carries their indices, a time delta and the raw arguments, so nothing is formatted while logging.
+// DumpTools binlog2txt turns it back into the lines of the text log. Plain C++ so that DumpTools can read it.
+//
+// The file is a sequence of records, each a type byte and its fields. Integers are LEB128 varints, signed
+// ones zigzag encoded first, strings a varint length and the bytes, doubles 8 bytes little endian.
+//   Session: "PBL1" | u8 version | str process id | svarint start time (us since epoch), starts the tables
+//   Chunk:   str process id, the following records belong to the session of that process
+//   Site:    varint index | svarint line | str file | str function | str format
+//   Thread:  varint index | str thread id
+//   Rt:      varint site | varint thread | u8 level | svarint us since the previous event | u8 count | args,
+//            each an u8 myLogArg::Type and the value (svarint, varint, double or varint)
+//   Text:    varint site | varint thread | u8 level | svarint us since the previous event | str message
+//   Note:    str text, a line of the logger itself
+// Each flush appends one chunk, so processes that share the file keep apart.
+#include "myLogFormatter.h"
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+// Not thread safe, the logger's worker thread owns it
+class myBinLogWriter
+{
+public:
+    // Starts a new session in path, the file is only touched by flush
+    void open(const std::string &path, const std::string &processId);
+    // siteKey identifies the call site, its strings are read the first time it is seen. The path of file and
+    // the scope of function are dropped, as in the text log.
+    void writeRtEvent(const void *siteKey, const char *file, const char *function, int line, const char *format,
+                      std::thread::id threadId, int level, std::chrono::system_clock::time_point timestamp,
+                      const myLogArg *args, int numArgs);
+    // file and function must outlive the writer, the site is keyed by their addresses
+    void writeTextEvent(const char *file, const char *function, int line, std::thread::id threadId, int level,
+                        std::chrono::system_clock::time_point timestamp, const char *message, size_t length);
+    void writeNote(const std::string &text);
+    // Appends what was written since the last flush to the file, returns false if that failed
+    bool flush();
+    void close();
+
+    bool isOpen() const { return !path.empty(); }
+    size_t getPendingBytes() const { return buffer.size(); }
+
+private:
+    uint32_t getThreadIndex(std::thread::id threadId);
+    void writeEventHeader(uint8_t type, uint32_t site, std::thread::id threadId, int level,
+                          std::chrono::system_clock::time_point timestamp);
+    void beginChunk();
+    void resetSession();
+
+    std::string path, processId;
+    std::vector<uint8_t> buffer;
+    bool sessionStarted = false;
+    int64_t lastMicros = 0;
+    uint32_t numSites = 0;
+    std::unordered_map<const void *, uint32_t> rtSites;
+    std::map<std::tuple<const void *, const void *, int>, uint32_t> textSites;
+    std::unordered_map<std::thread::id, uint32_t> threads;
+};
+
+class myBinLogReader
+{
+public:
+    struct Event {
+        bool isNote = false; // text is the whole line, the other fields are unused
+        std::chrono::system_clock::time_point timestamp;
+        std::string processId, threadId;
+        int level = 0;
+        std::string file, function;
+        int line = 0;
+        std::string text;
+    };
+
+    // Reads the whole file, returns false if it cannot be read or is not a binary log
+    bool open(const std::string &path);
+    // Returns false at the end of the file or at the first damaged record, see isDamaged
+    bool next(Event &event);
+    bool isDamaged() const { return damaged; }
+
+private:
+    struct Site {
+        std::string file, function, format;
+        int line = 0;
+    };
+    struct Session {
+        int64_t lastMicros = 0;
+        std::vector<Site> sites;
+        std::vector<std::string> threads;
+    };
+
+    bool readVarint(uint64_t &value);
+    bool readSigned(int64_t &value);
+    bool readString(std::string &value);
+    bool readEvent(uint8_t type, Event &event);
+
+    std::vector<uint8_t> data;
+    size_t position = 0;
+    bool damaged = false;
+    std::map<std::string, Session> sessions;
+    std::string currentProcessId;
+    Session *current = nullptr;
+    myLogArg args[255];
+};
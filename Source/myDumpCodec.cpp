@@ -0,0 +1,348 @@
+/***************************************************************************
+ * Description: myDumpCodec
+ * version: 0.1.0
+ * Author: Panda-Young
+ * Date: 2026-10-17 16:11:48
+ * Copyright (c) 2024 by Panda-Young, All Rights Reserved.
+ **************************************************************************/
+
+#include "myDumpCodec.h"
+#include <cmath>
+#include <cstring>
+
+static constexpr int kMaxOrder = 3;
+static constexpr uint32_t kEscapeQuotient = 24; // longer unary codes are replaced by the raw 32-bit residual
+static constexpr uint8_t kVerbatim = 0xFF;
+static constexpr uint8_t kIntegerDomain = 0x80; // set in the mode byte when the channel holds 24-bit integer samples
+static constexpr float kIntegerScale = 8388608.0f;
+static constexpr size_t kChannelHeaderBytes = 7;
+
+static void putLE32(uint8_t *dest, uint32_t value)
+{
+    for (int i = 0; i < 4; i++) {
+        dest[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+static uint32_t getLE32(const uint8_t *src)
+{
+    return static_cast<uint32_t>(src[0]) | static_cast<uint32_t>(src[1]) << 8 | static_cast<uint32_t>(src[2]) << 16 |
+           static_cast<uint32_t>(src[3]) << 24;
+}
+
+// Maps the float bit pattern to an integer that grows with the float value, -0.0 and +0.0 stay distinct
+static uint32_t floatToOrdered(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return (bits & 0x80000000u) ? ~(bits & 0x7FFFFFFFu) : bits;
+}
+
+static float orderedToFloat(uint32_t ordered)
+{
+    uint32_t bits = (ordered & 0x80000000u) ? (~ordered | 0x80000000u) : ordered;
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Residuals wrap modulo 2^32, which keeps the round trip exact even when the prediction overflows
+static uint32_t predict(const uint32_t *x, int i, int order)
+{
+    switch (order) {
+    case 1:
+        return x[i - 1];
+    case 2:
+        return 2 * x[i - 1] - x[i - 2];
+    case 3:
+        return 3 * x[i - 1] - 3 * x[i - 2] + x[i - 3];
+    default:
+        return 0;
+    }
+}
+
+// Integer taps converted to float (16 or 24-bit sources) are coded as integers, with the common trailing
+// zero bits shifted out, which compresses them about as well as FLAC would
+static bool toIntegerDomain(const float *interleaved, int numChannels, int channel, int numFrames, uint32_t *x,
+                            int &shift)
+{
+    uint32_t used = 0;
+    for (int i = 0; i < numFrames; i++) {
+        const float value = interleaved[i * numChannels + channel];
+        const float scaled = value * kIntegerScale;
+        if (!(std::fabs(scaled) <= 16777216.0f) || scaled != static_cast<float>(static_cast<int32_t>(scaled)) ||
+            (std::signbit(value) && value == 0.0f)) {
+            return false;
+        }
+        x[i] = static_cast<uint32_t>(static_cast<int32_t>(scaled));
+        used |= x[i];
+    }
+    shift = 0;
+    while (used != 0 && shift < 24 && !(used & (1u << shift))) {
+        shift++;
+    }
+    for (int i = 0; i < numFrames; i++) {
+        x[i] = static_cast<uint32_t>(static_cast<int32_t>(x[i]) >> shift);
+    }
+    return true;
+}
+
+static uint32_t zigzag(uint32_t residual)
+{
+    return (residual << 1) ^ static_cast<uint32_t>(static_cast<int32_t>(residual) >> 31);
+}
+
+static uint32_t unzigzag(uint32_t value)
+{
+    return (value >> 1) ^ (0u - (value & 1));
+}
+
+namespace {
+struct BitWriter {
+    uint8_t *out;
+    uint64_t acc = 0;
+    int bits = 0;
+
+    void put(uint32_t value, int numBits)
+    {
+        acc = (acc << numBits) | value;
+        bits += numBits;
+        while (bits >= 8) {
+            bits -= 8;
+            *out++ = static_cast<uint8_t>(acc >> bits);
+        }
+    }
+    void flush()
+    {
+        if (bits > 0) {
+            *out++ = static_cast<uint8_t>(acc << (8 - bits));
+            bits = 0;
+        }
+    }
+};
+
+struct BitReader {
+    const uint8_t *in;
+    const uint8_t *end;
+    uint64_t acc = 0;
+    int bits = 0;
+    bool overrun = false;
+
+    uint32_t get(int numBits)
+    {
+        while (bits < numBits) {
+            if (in == end) {
+                overrun = true;
+                return 0;
+            }
+            acc = (acc << 8) | *in++;
+            bits += 8;
+        }
+        bits -= numBits;
+        return static_cast<uint32_t>((acc >> bits) & ((1ull << numBits) - 1));
+    }
+};
+} // namespace
+
+void encodeDumpFileHeader(uint8_t (&header)[kDumpCodecFileHeaderBytes], uint16_t numChannels, uint32_t sampleRate)
+{
+    std::memcpy(header, "PDZ1", 4);
+    header[4] = static_cast<uint8_t>(numChannels);
+    header[5] = static_cast<uint8_t>(numChannels >> 8);
+    header[6] = 0;
+    header[7] = 0;
+    putLE32(header + 8, sampleRate);
+    putLE32(header + 12, kDumpCodecBlockFrames);
+}
+
+bool decodeDumpFileHeader(const uint8_t (&header)[kDumpCodecFileHeaderBytes], uint16_t &numChannels,
+                          uint32_t &sampleRate, uint32_t &blockFrames)
+{
+    if (std::memcmp(header, "PDZ1", 4) != 0) {
+        return false;
+    }
+    numChannels = static_cast<uint16_t>(header[4] | header[5] << 8);
+    sampleRate = getLE32(header + 8);
+    blockFrames = getLE32(header + 12);
+    return numChannels > 0 && blockFrames > 0;
+}
+
+size_t dumpCodecMaxBytes(int numChannels, int numFrames)
+{
+    size_t numBlocks = static_cast<size_t>((numFrames + kDumpCodecBlockFrames - 1) / kDumpCodecBlockFrames);
+    return numBlocks * (kDumpCodecBlockHeaderBytes + static_cast<size_t>(numChannels) * kChannelHeaderBytes) +
+           static_cast<size_t>(numFrames) * static_cast<size_t>(numChannels) * sizeof(float);
+}
+
+static uint8_t *encodeChannel(const float *interleaved, int numChannels, int channel, int numFrames, uint8_t *dest)
+{
+    uint32_t x[kDumpCodecBlockFrames];
+    int shift = 0;
+    const bool isInteger = toIntegerDomain(interleaved, numChannels, channel, numFrames, x, shift);
+    if (!isInteger) {
+        for (int i = 0; i < numFrames; i++) {
+            x[i] = floatToOrdered(interleaved[i * numChannels + channel]);
+        }
+    }
+
+    // pick the fixed predictor with the smallest residual magnitude, the first kMaxOrder samples are left out
+    // so that all orders are compared over the same range
+    uint64_t sums[kMaxOrder + 1] = {0};
+    for (int i = kMaxOrder; i < numFrames; i++) {
+        for (int order = 0; order <= kMaxOrder; order++) {
+            sums[order] += zigzag(x[i] - predict(x, i, order));
+        }
+    }
+    int order = 0;
+    for (int candidate = 1; candidate <= kMaxOrder; candidate++) {
+        if (sums[candidate] < sums[order]) {
+            order = candidate;
+        }
+    }
+    order = numFrames > order ? order : 0;
+
+    uint64_t sum = 0;
+    for (int i = order; i < numFrames; i++) {
+        sum += zigzag(x[i] - predict(x, i, order));
+    }
+    const uint64_t count = static_cast<uint64_t>(numFrames - order);
+    int k = 0;
+    while (k < 30 && (count << (k + 1)) < sum) {
+        k++;
+    }
+
+    uint64_t estimatedBits = 32ull * static_cast<uint64_t>(order);
+    for (int i = order; i < numFrames; i++) {
+        uint32_t q = zigzag(x[i] - predict(x, i, order)) >> k;
+        estimatedBits += q < kEscapeQuotient ? q + 1 + k : kEscapeQuotient + 32;
+    }
+
+    uint8_t *data = dest + kChannelHeaderBytes;
+    if (estimatedBits / 8 + 1 >= static_cast<uint64_t>(numFrames) * sizeof(float)) {
+        for (int i = 0; i < numFrames; i++) {
+            uint32_t bits;
+            std::memcpy(&bits, &interleaved[i * numChannels + channel], sizeof(bits));
+            putLE32(data + 4 * i, bits);
+        }
+        dest[0] = kVerbatim;
+        dest[1] = 0;
+        dest[2] = 0;
+        putLE32(dest + 3, static_cast<uint32_t>(numFrames * sizeof(float)));
+        return data + numFrames * sizeof(float);
+    }
+
+    for (int i = 0; i < order; i++) {
+        putLE32(data + 4 * i, x[i]);
+    }
+    BitWriter writer{data + 4 * order};
+    for (int i = order; i < numFrames; i++) {
+        uint32_t u = zigzag(x[i] - predict(x, i, order));
+        uint32_t q = u >> k;
+        if (q < kEscapeQuotient) {
+            // q ones and a terminating zero, then the k low bits
+            writer.put(((1u << q) - 1) << 1, static_cast<int>(q) + 1);
+            if (k > 0) {
+                writer.put(u & ((1u << k) - 1), k);
+            }
+        } else {
+            writer.put((1u << kEscapeQuotient) - 1, kEscapeQuotient);
+            writer.put(u, 32);
+        }
+    }
+    writer.flush();
+    dest[0] = static_cast<uint8_t>(order | (isInteger ? kIntegerDomain : 0));
+    dest[1] = static_cast<uint8_t>(k);
+    dest[2] = static_cast<uint8_t>(shift);
+    putLE32(dest + 3, static_cast<uint32_t>(writer.out - data));
+    return writer.out;
+}
+
+size_t encodeDumpFrames(const float *interleaved, int numChannels, int numFrames, uint8_t *dest)
+{
+    uint8_t *out = dest;
+    for (int start = 0; start < numFrames; start += kDumpCodecBlockFrames) {
+        const int frames = numFrames - start < kDumpCodecBlockFrames ? numFrames - start : kDumpCodecBlockFrames;
+        uint8_t *blockHeader = out;
+        out += kDumpCodecBlockHeaderBytes;
+        for (int channel = 0; channel < numChannels; channel++) {
+            out = encodeChannel(interleaved + static_cast<size_t>(start) * numChannels, numChannels, channel, frames,
+                                out);
+        }
+        putLE32(blockHeader, static_cast<uint32_t>(frames));
+        putLE32(blockHeader + 4, static_cast<uint32_t>(out - blockHeader - kDumpCodecBlockHeaderBytes));
+    }
+    return static_cast<size_t>(out - dest);
+}
+
+bool decodeDumpBlockHeader(const uint8_t *src, int maxFrames, int &numFrames, size_t &payloadBytes)
+{
+    uint32_t frames = getLE32(src);
+    if (frames == 0 || frames > static_cast<uint32_t>(maxFrames) || frames > kDumpCodecBlockFrames) {
+        return false;
+    }
+    numFrames = static_cast<int>(frames);
+    payloadBytes = getLE32(src + 4);
+    return true;
+}
+
+bool decodeDumpBlockPayload(const uint8_t *payload, size_t payloadBytes, int numChannels, int numFrames,
+                            float *interleaved)
+{
+    const uint8_t *in = payload;
+    const uint8_t *end = payload + payloadBytes;
+    uint32_t x[kDumpCodecBlockFrames];
+    for (int channel = 0; channel < numChannels; channel++) {
+        if (end - in < static_cast<ptrdiff_t>(kChannelHeaderBytes)) {
+            return false;
+        }
+        const uint8_t mode = in[0];
+        const int k = in[1];
+        const int shift = in[2];
+        const uint32_t channelBytes = getLE32(in + 3);
+        in += kChannelHeaderBytes;
+        if (channelBytes > static_cast<size_t>(end - in)) {
+            return false;
+        }
+        const uint8_t *channelEnd = in + channelBytes;
+
+        if (mode == kVerbatim) {
+            if (channelBytes != numFrames * sizeof(float)) {
+                return false;
+            }
+            for (int i = 0; i < numFrames; i++) {
+                uint32_t bits = getLE32(in + 4 * i);
+                std::memcpy(&interleaved[i * numChannels + channel], &bits, sizeof(bits));
+            }
+            in = channelEnd;
+            continue;
+        }
+        const bool isInteger = (mode & kIntegerDomain) != 0;
+        const int order = mode & ~kIntegerDomain;
+        if (order > kMaxOrder || order > numFrames || k > 30 || shift > 24 || channelBytes < 4u * order) {
+            return false;
+        }
+
+        for (int i = 0; i < order; i++) {
+            x[i] = getLE32(in + 4 * i);
+        }
+        BitReader reader{in + 4 * order, channelEnd};
+        for (int i = order; i < numFrames; i++) {
+            uint32_t q = 0;
+            while (q < kEscapeQuotient && reader.get(1)) {
+                q++;
+            }
+            uint32_t u = q < kEscapeQuotient ? (q << k) | (k > 0 ? reader.get(k) : 0) : reader.get(32);
+            if (reader.overrun) {
+                return false;
+            }
+            x[i] = unzigzag(u) + predict(x, i, order);
+        }
+        for (int i = 0; i < numFrames; i++) {
+            interleaved[i * numChannels + channel] =
+                isInteger ? static_cast<float>(static_cast<int32_t>(x[i] << shift)) / kIntegerScale
+                          : orderedToFloat(x[i]);
+        }
+        in = channelEnd;
+    }
+    return in == end;
+}
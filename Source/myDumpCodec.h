@@ -0,0 +1,44 @@
+/***************************************************************************
+ * Description: Header of myDumpCodec
+ * version: 0.1.0
+ * Author: Panda-Young
+ * Date: 2026-10-17 16:11:48
+ * Copyright (c) 2024 by Panda-Young, All Rights Reserved.
+ **************************************************************************/
+
+#pragma once
+
+// Lossless codec for the 32-bit float data dumps (.pdz), plain C++ so that DumpTools can decode it.
+//
+// Per channel and block, samples that are all 24-bit integers in disguise are coded as integers, any
+// other float bit pattern is mapped to an order-preserving integer. Either is predicted with the best of
+// the fixed FLAC polynomials (order 0 to 3) and the residuals are Rice coded. Every bit pattern
+// round-trips exactly, NaN and -0.0 included, and a channel that does not compress is stored verbatim.
+//
+// File:  "PDZ1" | uint16 channels | uint16 reserved | uint32 sample rate | uint32 block frames
+// Block: uint32 frames | uint32 payload bytes | per channel: uint8 mode | uint8 rice k | uint8 shift |
+//        uint32 bytes | data
+// All fields are little endian. A block is independent of the others, so a truncated file decodes up
+// to its last complete block.
+#include <cstddef>
+#include <cstdint>
+
+constexpr size_t kDumpCodecFileHeaderBytes = 16;
+constexpr size_t kDumpCodecBlockHeaderBytes = 8;
+constexpr int kDumpCodecBlockFrames = 4096;
+
+void encodeDumpFileHeader(uint8_t (&header)[kDumpCodecFileHeaderBytes], uint16_t numChannels, uint32_t sampleRate);
+// Returns false if header is not a .pdz file header
+bool decodeDumpFileHeader(const uint8_t (&header)[kDumpCodecFileHeaderBytes], uint16_t &numChannels,
+                          uint32_t &sampleRate, uint32_t &blockFrames);
+
+// Upper bound of the encoded size of numFrames frames, whatever the content
+size_t dumpCodecMaxBytes(int numChannels, int numFrames);
+// Encodes interleaved frames as ceil(numFrames / kDumpCodecBlockFrames) blocks, returns the bytes written
+size_t encodeDumpFrames(const float *interleaved, int numChannels, int numFrames, uint8_t *dest);
+
+// Reads the frame count and payload size of the block at src, returns false on a corrupt header
+bool decodeDumpBlockHeader(const uint8_t *src, int maxFrames, int &numFrames, size_t &payloadBytes);
+// Decodes one block payload into numFrames interleaved frames, returns false if the payload is corrupt
+bool decodeDumpBlockPayload(const uint8_t *payload, size_t payloadBytes, int numChannels, int numFrames,
+                            float *interleaved);
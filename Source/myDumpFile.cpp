@@ -0,0 +1,567 @@
+/***************************************************************************
+ * Description: myDumpFile
+ * version: 0.1.0
+ * Author: Panda-Young
+ * Date: 2026-10-17 18:12:40
+ * Copyright (c) 2024 by Panda-Young, All Rights Reserved.
+ **************************************************************************/
+
+#include "myDumpFile.h"
+#include "myLogger.h"
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+#if JUCE_LINUX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#if defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#endif
+#endif
+#endif
+
+// The ring layout used below needs the headers of Linux 5.4 or later, older ones only build the pwrite backend
+#if JUCE_LINUX && defined(IORING_FEAT_SINGLE_MMAP) && defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define MY_DUMP_FILE_IO_URING 1
+#else
+#define MY_DUMP_FILE_IO_URING 0
+#endif
+
+#if MY_DUMP_FILE_IO_URING
+// Raw system calls, so that no liburing is needed to build or run
+static int uringSetup(unsigned entries, io_uring_params *params)
+{
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int uringEnter(int ringFd, unsigned toSubmit, unsigned minComplete, unsigned flags)
+{
+    return static_cast<int>(syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+struct myDumpFile::Uring {
+    int ringFd = -1;
+    void *sqRing = MAP_FAILED;
+    size_t sqRingBytes = 0;
+    void *cqRing = MAP_FAILED;
+    size_t cqRingBytes = 0;
+    io_uring_sqe *sqes = static_cast<io_uring_sqe *>(MAP_FAILED);
+    size_t sqesBytes = 0;
+    unsigned *sqTail = nullptr;
+    unsigned *sqMask = nullptr;
+    unsigned *sqArray = nullptr;
+    unsigned *cqHead = nullptr;
+    unsigned *cqTail = nullptr;
+    unsigned *cqMask = nullptr;
+    io_uring_cqe *cqes = nullptr;
+    iovec iovs[kMaxQueueDepth] = {};
+
+    ~Uring()
+    {
+        if (sqes != MAP_FAILED) {
+            munmap(sqes, sqesBytes);
+        }
+        if (cqRing != MAP_FAILED && cqRing != sqRing) {
+            munmap(cqRing, cqRingBytes);
+        }
+        if (sqRing != MAP_FAILED) {
+            munmap(sqRing, sqRingBytes);
+        }
+        if (ringFd >= 0) {
+            ::close(ringFd);
+        }
+    }
+
+    bool setup(unsigned entries)
+    {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        if ((ringFd = uringSetup(entries, &params)) < 0) {
+            return false;
+        }
+        sqRingBytes = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingBytes = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        if (params.features & IORING_FEAT_SINGLE_MMAP) {
+            sqRingBytes = cqRingBytes = juce::jmax(sqRingBytes, cqRingBytes);
+        }
+        sqRing = mmap(nullptr, sqRingBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd,
+                      IORING_OFF_SQ_RING);
+        if (sqRing == MAP_FAILED) {
+            return false;
+        }
+        if (params.features & IORING_FEAT_SINGLE_MMAP) {
+            cqRing = sqRing;
+        } else {
+            cqRing = mmap(nullptr, cqRingBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd,
+                          IORING_OFF_CQ_RING);
+            if (cqRing == MAP_FAILED) {
+                return false;
+            }
+        }
+        sqesBytes = params.sq_entries * sizeof(io_uring_sqe);
+        sqes = static_cast<io_uring_sqe *>(mmap(nullptr, sqesBytes, PROT_READ | PROT_WRITE,
+                                                MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES));
+        if (sqes == MAP_FAILED) {
+            return false;
+        }
+
+        char *sq = static_cast<char *>(sqRing);
+        char *cq = static_cast<char *>(cqRing);
+        sqTail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+        sqMask = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+        sqArray = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+        cqHead = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+        cqTail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+        cqMask = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+        return true;
+    }
+
+    // Queues one write, there is at most one per buffer so the submission queue never overflows
+    int submitWrite(int fileFd, int index, const void *data, size_t numBytes, uint64_t offset)
+    {
+        iovs[index].iov_base = const_cast<void *>(data);
+        iovs[index].iov_len = numBytes;
+        const unsigned tail = *sqTail;
+        const unsigned slot = tail & *sqMask;
+        io_uring_sqe *sqe = &sqes[slot];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = IORING_OP_WRITEV; // supported since the first io_uring kernels, unlike IORING_OP_WRITE
+        sqe->fd = fileFd;
+        sqe->addr = reinterpret_cast<uint64_t>(&iovs[index]);
+        sqe->len = 1;
+        sqe->off = offset;
+        sqe->user_data = static_cast<uint64_t>(index);
+        sqArray[slot] = slot;
+        __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+
+        int ret;
+        while ((ret = uringEnter(ringFd, 1, 0, 0)) < 0 && errno == EINTR) {
+        }
+        return ret < 0 ? errno : 0;
+    }
+};
+#else
+struct myDumpFile::Uring {
+};
+#endif
+
+static int64_t nowNanoseconds()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+static size_t alignUp(size_t value, size_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+static size_t alignDown(size_t value, size_t alignment)
+{
+    return value / alignment * alignment;
+}
+
+static char *alignPointer(char *pointer, size_t alignment)
+{
+    auto address = reinterpret_cast<uintptr_t>(pointer);
+    return pointer + (alignment - address % alignment) % alignment;
+}
+
+myDumpFile::myDumpFile() = default;
+
+myDumpFile::~myDumpFile()
+{
+    close();
+}
+
+const char *myDumpFile::getBackendName(Backend backend)
+{
+    switch (backend) {
+    case Backend::IoUring:
+        return "io_uring";
+    case Backend::Pwrite:
+        return "pwrite";
+    default:
+        return "stdio";
+    }
+}
+
+bool myDumpFile::open(const juce::File &fileToOpen, size_t bytesPerBuffer)
+{
+    close();
+    file = fileToOpen;
+    bufferBytes = alignUp(juce::jmax(bytesPerBuffer, kBlockBytes), kBlockBytes);
+    try {
+        for (auto &buffer : buffers) {
+            buffer.storage = std::make_unique<char[]>(bufferBytes + kBlockBytes);
+            buffer.data = alignPointer(buffer.storage.get(), kBlockBytes);
+            buffer.inFlight = false;
+        }
+        headStorage = std::make_unique<char[]>(2 * kBlockBytes);
+        headBlock = alignPointer(headStorage.get(), kBlockBytes);
+    } catch (const std::bad_alloc &e) {
+        LOG_MSG(LOG_ERROR, "Failed to allocate data dump file buffers: " + std::string(e.what()));
+        return false;
+    }
+
+#if JUCE_LINUX
+    const juce::String pathName = file.getFullPathName();
+    const char *path = pathName.toUTF8();
+    direct = true;
+    fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC | O_DIRECT, 0644);
+    if (fd < 0 && errno == EINVAL) {
+        // the file system does not support O_DIRECT
+        direct = false;
+        fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    }
+    if (fd < 0) {
+        reportError("open", errno);
+        return false;
+    }
+#if MY_DUMP_FILE_IO_URING
+    uring = std::make_unique<Uring>();
+    if (uring->setup(kMaxQueueDepth)) {
+        backend = Backend::IoUring;
+    } else {
+        uring.reset();
+        backend = Backend::Pwrite;
+    }
+#else
+    backend = Backend::Pwrite;
+#endif
+#else
+    if ((filePtr = fopen(file.getFullPathName().toUTF8(), "wb")) == nullptr) {
+        reportError("open", errno);
+        return false;
+    }
+    // buffers are already large, stdio buffering would only add a copy
+    setvbuf(filePtr, nullptr, _IONBF, 0);
+    backend = Backend::Stdio;
+    direct = false;
+#endif
+
+    opened = true;
+    failed = false;
+    current = 0;
+    bufferOffset = 0;
+    fill = 0;
+    flushedFill = 0;
+    size = 0;
+    cacheOffset = 0;
+    cacheBytes = 0;
+    queueDepth.store(0, std::memory_order_relaxed);
+    maxQueueDepth.store(0, std::memory_order_relaxed);
+    bytesCompleted.store(0, std::memory_order_relaxed);
+    busyNanoseconds.store(0, std::memory_order_relaxed);
+    return true;
+}
+
+bool myDumpFile::append(const void *data, size_t numBytes)
+{
+    if (!opened || failed) {
+        return false;
+    }
+    if (backend == Backend::IoUring && !reapCompletions(false)) {
+        return false;
+    }
+    const char *source = static_cast<const char *>(data);
+    while (numBytes > 0) {
+        Buffer &buffer = buffers[current];
+        if (buffer.inFlight && !waitFor(current)) {
+            return false;
+        }
+        const size_t count = juce::jmin(numBytes, bufferBytes - fill);
+        std::memcpy(buffer.data + fill, source, count);
+        fill += count;
+        size += count;
+        source += count;
+        numBytes -= count;
+        if (fill == bufferBytes) {
+            if (!submit(direct ? alignDown(flushedFill, kBlockBytes) : flushedFill, bufferBytes)) {
+                return false;
+            }
+            bufferOffset += bufferBytes;
+            current = (current + 1) % kMaxQueueDepth;
+            fill = 0;
+            flushedFill = 0;
+        }
+    }
+    return true;
+}
+
+bool myDumpFile::overwriteHead(const void *data, size_t numBytes)
+{
+    if (!opened || failed || numBytes > kBlockBytes || numBytes > size) {
+        return false;
+    }
+    if (bufferOffset == 0) {
+        // the first buffer is still being filled, the next write of it takes the change along
+        if (!waitFor(current)) {
+            return false;
+        }
+        std::memcpy(buffers[current].data, data, numBytes);
+        flushedFill = 0;
+        return true;
+    }
+    if (!waitAll()) {
+        return false;
+    }
+    if (direct) {
+        std::memcpy(headBlock, data, numBytes);
+        return writeSync(headBlock, kBlockBytes, 0);
+    }
+    return writeSync(data, numBytes, 0);
+}
+
+bool myDumpFile::flush()
+{
+    if (!opened || failed) {
+        return false;
+    }
+    if (fill > flushedFill) {
+        Buffer &buffer = buffers[current];
+        if (buffer.inFlight && !waitFor(current)) {
+            return false;
+        }
+        size_t start = flushedFill;
+        size_t end = fill;
+        if (direct) {
+            // whole blocks only, the zero padding is overwritten by later appends and trimmed on close
+            start = alignDown(start, kBlockBytes);
+            end = alignUp(end, kBlockBytes);
+            std::memset(buffer.data + fill, 0, end - fill);
+        }
+        if (!submit(start, end)) {
+            return false;
+        }
+        flushedFill = fill;
+    }
+    return waitAll();
+}
+
+bool myDumpFile::close()
+{
+    if (!opened) {
+        return true;
+    }
+    bool ok = flush();
+#if JUCE_LINUX
+    uring.reset();
+    if (direct && ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        reportError("trim", errno);
+        ok = false;
+    }
+    if (!direct && cacheBytes > 0) {
+        releaseCache(0, 0);
+    }
+    if (::close(fd) != 0) {
+        reportError("close", errno);
+        ok = false;
+    }
+    fd = -1;
+#else
+    if (fclose(filePtr) != 0) {
+        reportError("close", errno);
+        ok = false;
+    }
+    filePtr = nullptr;
+#endif
+    opened = false;
+    for (auto &buffer : buffers) {
+        buffer.storage.reset();
+        buffer.data = nullptr;
+    }
+    headStorage.reset();
+    headBlock = nullptr;
+    return ok && !failed;
+}
+
+bool myDumpFile::submit(size_t start, size_t end)
+{
+    if (start >= end) {
+        return true;
+    }
+    Buffer &buffer = buffers[current];
+    if (direct && bufferOffset == 0) {
+        std::memcpy(headBlock, buffer.data, kBlockBytes);
+    }
+    buffer.writeData = buffer.data + start;
+    buffer.writeOffset = bufferOffset + start;
+    buffer.writeLength = end - start;
+    buffer.inFlight = true;
+    writeStarted();
+
+#if MY_DUMP_FILE_IO_URING
+    if (backend == Backend::IoUring) {
+        int error = uring->submitWrite(fd, current, buffer.writeData, buffer.writeLength, buffer.writeOffset);
+        if (error != 0) {
+            reportError("queue a write to", error);
+            completeWrite(current);
+            return false;
+        }
+        return true;
+    }
+#endif
+    bool written = writeSync(buffer.writeData, buffer.writeLength, buffer.writeOffset);
+    completeWrite(current);
+    return written;
+}
+
+bool myDumpFile::writeSync(const void *data, size_t numBytes, uint64_t offset)
+{
+#if JUCE_LINUX
+    const char *source = static_cast<const char *>(data);
+    while (numBytes > 0) {
+        ssize_t written = pwrite(fd, source, numBytes, static_cast<off_t>(offset));
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            reportError("write", errno);
+            return false;
+        }
+        source += written;
+        offset += static_cast<uint64_t>(written);
+        numBytes -= static_cast<size_t>(written);
+    }
+    return true;
+#else
+    if (!seekTo(offset) || fwrite(data, 1, numBytes, filePtr) != numBytes) {
+        reportError("write", errno);
+        return false;
+    }
+    return true;
+#endif
+}
+
+#if !JUCE_LINUX
+bool myDumpFile::seekTo(uint64_t offset)
+{
+#if JUCE_WINDOWS
+    return _fseeki64(filePtr, static_cast<__int64>(offset), SEEK_SET) == 0;
+#else
+    return fseeko(filePtr, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+}
+#endif
+
+bool myDumpFile::waitFor(int index)
+{
+    while (buffers[index].inFlight) {
+        if (!reapCompletions(true)) {
+            return false;
+        }
+    }
+    return !failed;
+}
+
+bool myDumpFile::waitAll()
+{
+    bool ok = true;
+    for (int i = 0; i < kMaxQueueDepth; i++) {
+        ok &= waitFor(i);
+    }
+    return ok;
+}
+
+bool myDumpFile::reapCompletions(bool wait)
+{
+#if MY_DUMP_FILE_IO_URING
+    if (!uring) {
+        return true;
+    }
+    if (wait) {
+        int ret;
+        while ((ret = uringEnter(uring->ringFd, 0, 1, IORING_ENTER_GETEVENTS)) < 0 && errno == EINTR) {
+        }
+        if (ret < 0) {
+            reportError("wait for", errno);
+            // nothing can be trusted to complete any more
+            for (int i = 0; i < kMaxQueueDepth; i++) {
+                if (buffers[i].inFlight) {
+                    completeWrite(i);
+                }
+            }
+            return false;
+        }
+    }
+    unsigned head = *uring->cqHead;
+    const unsigned tail = __atomic_load_n(uring->cqTail, __ATOMIC_ACQUIRE);
+    while (head != tail) {
+        const io_uring_cqe &cqe = uring->cqes[head & *uring->cqMask];
+        const int index = static_cast<int>(cqe.user_data);
+        Buffer &buffer = buffers[index];
+        if (cqe.res < 0) {
+            reportError("write", -cqe.res);
+        } else if (static_cast<size_t>(cqe.res) < buffer.writeLength) {
+            // short write, rare enough to finish it synchronously
+            const size_t done = static_cast<size_t>(cqe.res);
+            writeSync(buffer.writeData + done, buffer.writeLength - done, buffer.writeOffset + done);
+        }
+        completeWrite(index);
+        head++;
+    }
+    __atomic_store_n(uring->cqHead, head, __ATOMIC_RELEASE);
+#else
+    juce::ignoreUnused(wait);
+#endif
+    return !failed;
+}
+
+void myDumpFile::writeStarted()
+{
+    const int depth = queueDepth.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (depth == 1) {
+        busySince = nowNanoseconds();
+    }
+    if (depth > maxQueueDepth.load(std::memory_order_relaxed)) {
+        maxQueueDepth.store(depth, std::memory_order_relaxed);
+    }
+}
+
+void myDumpFile::completeWrite(int index)
+{
+    Buffer &buffer = buffers[index];
+    buffer.inFlight = false;
+    bytesCompleted.fetch_add(buffer.writeLength, std::memory_order_relaxed);
+    if (queueDepth.fetch_sub(1, std::memory_order_relaxed) == 1) {
+        busyNanoseconds.fetch_add(nowNanoseconds() - busySince, std::memory_order_relaxed);
+    }
+    if (!direct && backend != Backend::Stdio) {
+        releaseCache(buffer.writeOffset, buffer.writeLength);
+    }
+}
+
+void myDumpFile::releaseCache(uint64_t offset, size_t numBytes)
+{
+#if JUCE_LINUX
+    // Start the write-back of this range, then wait for the previous one, which had a whole write to
+    // get there, and drop its now clean pages. Dirty pages cannot be dropped, hence the one range delay.
+    if (numBytes > 0) {
+        sync_file_range(fd, static_cast<off_t>(offset), static_cast<off_t>(numBytes), SYNC_FILE_RANGE_WRITE);
+    }
+    if (cacheBytes > 0) {
+        sync_file_range(fd, static_cast<off_t>(cacheOffset), static_cast<off_t>(cacheBytes),
+                        SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+        posix_fadvise(fd, static_cast<off_t>(cacheOffset), static_cast<off_t>(cacheBytes), POSIX_FADV_DONTNEED);
+    }
+    cacheOffset = offset;
+    cacheBytes = numBytes;
+#else
+    juce::ignoreUnused(offset, numBytes);
+#endif
+}
+
+void myDumpFile::reportError(const char *what, int error)
+{
+    failed = true;
+    LOG_MSG(LOG_ERROR, "Failed to " + std::string(what) + " data dump file: \"" + file.getFullPathName().toStdString() +
+                           "\". Reason: " + std::string(strerror(error)));
+}
@@ -0,0 +1,113 @@
+/***************************************************************************
+ * Description: Header of myDumpFile
+ * version: 0.1.0
+ * Author: Panda-Young
+ * Date: 2026-10-17 18:12:40
+ * Copyright (c) 2024 by Panda-Young, All Rights Reserved.
+ **************************************************************************/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include <cstdio>
+#include <memory>
+
+// Append-only output file of the data dump writer, used from the writer thread only.
+// Appended bytes are gathered in a few aligned buffers; a full buffer is handed to the disk as one write.
+// On Linux the file is opened with O_DIRECT so a long capture does not push other processes out of the
+// page cache, and the writes are queued with io_uring so the writer thread keeps draining the audio rings
+// while up to kMaxQueueDepth buffers are on their way to the disk. Where io_uring is unavailable (old
+// kernel or kernel headers, seccomp) it falls back to pwrite, and where O_DIRECT is refused (tmpfs, some
+// network file systems) to buffered writes whose pages are dropped from the cache once written back.
+// Other platforms write through stdio.
+class myDumpFile
+{
+public:
+    enum class Backend {
+        Stdio,
+        Pwrite,
+        IoUring
+    };
+    static constexpr size_t kBlockBytes = 4096; // O_DIRECT alignment of buffers, lengths and offsets
+    static constexpr int kMaxQueueDepth = 4;
+
+    myDumpFile();
+    ~myDumpFile();
+
+    // bufferBytes is rounded up to a whole number of blocks
+    bool open(const juce::File &file, size_t bufferBytes);
+    // Queues the bytes at the end of the file, only waits when every buffer is still being written
+    bool append(const void *data, size_t numBytes);
+    // Overwrites the first numBytes (at most kBlockBytes) of what was appended, used to patch file headers
+    bool overwriteHead(const void *data, size_t numBytes);
+    // Writes everything appended so far and waits until the disk has it
+    bool flush();
+    // Flushes, trims the O_DIRECT padding and closes, returns false if any write failed
+    bool close();
+
+    bool isOpen() const { return opened; }
+    bool hasFailed() const { return failed; }
+    Backend getBackend() const { return backend; }
+    bool isDirect() const { return direct; }
+    uint64_t getSize() const { return size; }
+    static const char *getBackendName(Backend backend);
+
+    // Metrics, readable from any thread
+    int getQueueDepth() const { return queueDepth.load(std::memory_order_relaxed); }
+    int getMaxQueueDepth() const { return maxQueueDepth.load(std::memory_order_relaxed); }
+    uint64_t getBytesCompleted() const { return bytesCompleted.load(std::memory_order_relaxed); }
+    // Time with at least one write outstanding, bytes completed over it is the throughput of the disk
+    double getBusySeconds() const { return busyNanoseconds.load(std::memory_order_relaxed) * 1e-9; }
+
+private:
+    struct Buffer {
+        std::unique_ptr<char[]> storage;
+        char *data = nullptr; // kBlockBytes aligned view into storage
+        const char *writeData = nullptr;
+        uint64_t writeOffset = 0;
+        size_t writeLength = 0;
+        bool inFlight = false;
+    };
+    struct Uring;
+
+    bool submit(size_t start, size_t end);
+    bool writeSync(const void *data, size_t numBytes, uint64_t offset);
+    bool waitFor(int index);
+    bool waitAll();
+    bool reapCompletions(bool wait);
+    bool seekTo(uint64_t offset);
+    void completeWrite(int index);
+    void writeStarted();
+    void releaseCache(uint64_t offset, size_t numBytes);
+    void reportError(const char *what, int error);
+
+    juce::File file;
+    Backend backend = Backend::Stdio;
+    bool direct = false;
+    bool opened = false;
+    bool failed = false;
+    int fd = -1;
+    FILE *filePtr = nullptr;
+    std::unique_ptr<Uring> uring;
+
+    Buffer buffers[kMaxQueueDepth];
+    size_t bufferBytes = 0;
+    int current = 0;
+    uint64_t bufferOffset = 0; // file offset of the current buffer
+    size_t fill = 0;           // bytes appended to the current buffer
+    size_t flushedFill = 0;    // of which already written by flush()
+    uint64_t size = 0;
+    std::unique_ptr<char[]> headStorage;
+    char *headBlock = nullptr; // copy of the first block, O_DIRECT can only rewrite whole blocks
+    uint64_t cacheOffset = 0;  // range still to be dropped from the page cache in buffered mode
+    size_t cacheBytes = 0;
+
+    std::atomic<int> queueDepth{0};
+    std::atomic<int> maxQueueDepth{0};
+    std::atomic<uint64_t> bytesCompleted{0};
+    std::atomic<int64_t> busyNanoseconds{0};
+    int64_t busySince = 0;
+
+    JUCE_DECLARE_NON_COPYABLE(myDumpFile)
+};
@@ -0,0 +1,269 @@
+/***************************************************************************
+ * Description: myDumpHousekeeper
+ * version: 0.1.0
+ * Author: Panda-Young
+ * Date: 2026-10-17 20:41:12
+ * Copyright (c) 2024 by Panda-Young, All Rights Reserved.
+ **************************************************************************/
+
+#include "myDumpHousekeeper.h"
+#include "myLogger.h"
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+// File systems store modification times coarser than the clock (down to 2 s on FAT), files modified this
+// long before the folder was set may still belong to the session that is starting
+static constexpr double kScanMarginSeconds = 2.0;
+
+myDumpHousekeeper::~myDumpHousekeeper()
+{
+    if (housekeepingThread.joinable()) {
+        // a pass that was already queued still runs, so the files of the last session are looked at
+        {
+            std::lock_guard<std::mutex> lock(requestMutex);
+            threadRunning = false;
+        }
+        requestCondition.notify_all();
+        housekeepingThread.join();
+    }
+}
+
+void myDumpHousekeeper::setDirectory(const juce::File &directory)
+{
+    std::lock_guard<std::mutex> lock(requestMutex);
+    if (directory != dumpDirectory) {
+        dumpDirectory = directory;
+        scanBefore = juce::Time::getCurrentTime();
+        scanPending = true;
+        passPending = true;
+    }
+    startThread();
+    requestCondition.notify_one();
+}
+
+void myDumpHousekeeper::setPolicy(const RetentionPolicy &policy)
+{
+    std::lock_guard<std::mutex> lock(requestMutex);
+    retention = policy;
+}
+
+void myDumpHousekeeper::addFiles(const juce::Array<juce::File> &files)
+{
+    std::lock_guard<std::mutex> lock(requestMutex);
+    pendingFiles.addArray(files);
+}
+
+void myDumpHousekeeper::requestCleanup()
+{
+    std::lock_guard<std::mutex> lock(requestMutex);
+    passPending = true;
+    startThread();
+    requestCondition.notify_one();
+}
+
+void myDumpHousekeeper::startThread()
+{
+    // requestMutex is held
+    if (!housekeepingThread.joinable()) {
+        threadRunning = true;
+        housekeepingThread = std::thread(&myDumpHousekeeper::housekeepingLoop, this);
+    }
+}
+
+void myDumpHousekeeper::housekeepingLoop()
+{
+    for (;;) {
+        {
+            // sleeps until a pass is queued, a queued pass still runs when the thread is asked to stop
+            std::unique_lock<std::mutex> lock(requestMutex);
+            requestCondition.wait(lock, [this] { return passPending || !threadRunning; });
+            if (!passPending) {
+                break;
+            }
+        }
+        runPass();
+    }
+}
+
+void myDumpHousekeeper::runPass()
+{
+    juce::File directory;
+    juce::Time before;
+    bool scan;
+    RetentionPolicy policy;
+    juce::Array<juce::File> files;
+    {
+        std::lock_guard<std::mutex> lock(requestMutex);
+        directory = dumpDirectory;
+        before = scanBefore;
+        scan = scanPending;
+        policy = retention;
+        files.swapWith(pendingFiles);
+        scanPending = false;
+        passPending = false;
+    }
+    if (directory == juce::File()) {
+        return;
+    }
+
+    if (directory != indexedDirectory) {
+        index.clear();
+        totalBytes = 0;
+        indexedDirectory = directory;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    if (scan) {
+        scanDirectory(directory, before);
+    }
+    for (const auto &file : files) {
+        if (file.isAChildOf(directory)) {
+            indexFile(file);
+        }
+    }
+    applyPolicy(policy);
+    indexedBytes.store(totalBytes, std::memory_order_relaxed);
+    indexedFiles.store(static_cast<int>(index.size()), std::memory_order_relaxed);
+
+    // deleteFile only removes a directory that is empty, so a session that has started meanwhile keeps it
+    if (index.empty() && directory.isDirectory() &&
+        directory.getNumberOfChildFiles(juce::File::findFilesAndDirectories) == 0 && directory.deleteFile()) {
+        LOG_MSG(LOG_DEBUG, "The folder \"" + directory.getFullPathName().toStdString() +
+                               "\" is empty and deleted successfully.");
+    }
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    LOG_MSG(LOG_DEBUG, "Data dump housekeeping took " + std::to_string(ms) + " ms, " + std::to_string(index.size()) +
+                           " files with " + std::to_string(totalBytes) + " bytes are kept");
+}
+
+void myDumpHousekeeper::scanDirectory(const juce::File &directory, juce::Time before)
+{
+    // the plugin writes straight into the folder, subfolders are the user's
+    juce::Array<juce::File> children;
+    directory.findChildFiles(children, juce::File::findFiles, false);
+    const juce::Time cutoff = before - juce::RelativeTime::seconds(kScanMarginSeconds);
+    int skipped = 0;
+    for (const auto &file : children) {
+        if (file.getLastModificationTime() >= cutoff) {
+            // written by a session that started after the folder was set, it is added when it is closed
+            skipped++;
+            continue;
+        }
+        indexFile(file);
+    }
+    LOG_MSG(LOG_INFO, "Indexed " + std::to_string(index.size()) + " data dump files with " +
+                          std::to_string(totalBytes) + " bytes in \"" + directory.getFullPathName().toStdString() +
+                          "\", skipped " + std::to_string(skipped) + " of the current session");
+}
+
+void myDumpHousekeeper::indexFile(const juce::File &file)
+{
+    if (!isDumpFile(file)) {
+        return;
+    }
+    const std::string path = file.getFullPathName().toStdString();
+    auto existing = index.find(path);
+    if (existing != index.end()) {
+        totalBytes -= existing->second.size;
+        index.erase(existing);
+    }
+    if (!file.existsAsFile()) {
+        return;
+    }
+    const int64_t size = file.getSize();
+    if (size == 0) {
+        if (file.deleteFile()) {
+            LOG_MSG(LOG_DEBUG, "The file \"" + path + "\" is empty and deleted successfully.");
+        } else {
+            LOG_MSG(LOG_ERROR, "Failed to delete the empty file \"" + path + "\"");
+        }
+        return;
+    }
+    Entry entry;
+    entry.size = static_cast<uint64_t>(size);
+    entry.modified = file.getLastModificationTime();
+    index[path] = entry;
+    totalBytes += entry.size;
+}
+
+bool myDumpHousekeeper::hasTimeStampPrefix(const juce::String &name)
+{
+    // "2024-07-06_152930_"
+    if (name.length() <= 18 || name[4] != '-' || name[7] != '-' || name[10] != '_' || name[17] != '_') {
+        return false;
+    }
+    for (int i : {0, 1, 2, 3, 5, 6, 8, 9, 11, 12, 13, 14, 15, 16}) {
+        if (!juce::CharacterFunctions::isDigit(name[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool myDumpHousekeeper::isDumpFile(const juce::File &file)
+{
+    // the dump taps, the frame sidecar, the raw dumps of older versions and the flight recordings
+    return hasTimeStampPrefix(file.getFileName()) && file.hasFileExtension("wav;pdz;pdmeta;pcm");
+}
+
+std::string myDumpHousekeeper::getSessionKey(const juce::File &file)
+{
+    // "2024-07-06_152930_input.wav": the files of one session share the time stamp and the folder
+    const juce::String name = file.getFileName();
+    const juce::String key = hasTimeStampPrefix(name) ? name.substring(0, 18) : name;
+    return file.getParentDirectory().getChildFile(key).getFullPathName().toStdString();
+}
+
+void myDumpHousekeeper::applyPolicy(const RetentionPolicy &policy)
+{
+    if (policy.maxTotalBytes == 0 && policy.maxAgeDays <= 0 && policy.maxFiles <= 0) {
+        return;
+    }
+    struct Session {
+        std::string key;
+        juce::Time newest;
+        std::vector<std::string> paths;
+    };
+    std::map<std::string, Session> byKey;
+    for (const auto &item : index) {
+        Session &session = byKey[getSessionKey(juce::File(item.first))];
+        session.newest = juce::jmax(session.newest, item.second.modified);
+        session.paths.push_back(item.first);
+    }
+    std::vector<Session *> sessions;
+    for (auto &item : byKey) {
+        item.second.key = item.first;
+        sessions.push_back(&item.second);
+    }
+    std::sort(sessions.begin(), sessions.end(),
+              [](const Session *a, const Session *b) { return a->newest < b->newest; });
+
+    const juce::Time expiry = juce::Time::getCurrentTime() - juce::RelativeTime::days(policy.maxAgeDays);
+    // sessions are in age order and deleting only lowers the totals, so the first one that may stay ends it;
+    // the newest session is the one that has just been recorded and is never deleted
+    for (size_t i = 0; i + 1 < sessions.size(); i++) {
+        const Session &session = *sessions[i];
+        const bool expired = policy.maxAgeDays > 0 && session.newest < expiry;
+        const bool tooLarge = policy.maxTotalBytes > 0 && totalBytes > policy.maxTotalBytes;
+        const bool tooMany = policy.maxFiles > 0 && index.size() > static_cast<size_t>(policy.maxFiles);
+        if (!expired && !tooLarge && !tooMany) {
+            break;
+        }
+        uint64_t freedBytes = 0;
+        int deleted = 0;
+        for (const auto &path : session.paths) {
+            juce::File file(path);
+            if (file.deleteFile() || !file.exists()) {
+                freedBytes += index[path].size;
+                totalBytes -= index[path].size;
+                index.erase(path);
+                deleted++;
+            } else {
+                LOG_MSG(LOG_ERROR, "Failed to delete the data dump file \"" + path + "\"");
+            }
+        }
+        LOG_MSG(LOG_INFO, "Retention policy (" + std::string(expired ? "age" : tooLarge ? "size" : "count") +
+                              ") deleted " + std::to_string(deleted) + " files with " + std::to_string(freedBytes) +
+                              " bytes of \"" + session.key + "\"");
+    }
+}
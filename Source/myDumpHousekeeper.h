@@ -0,0 +1,89 @@
+/***************************************************************************
+ * Description: Header of myDumpHousekeeper
+ * version: 0.1.0
+ * Author: Panda-Young
+ * Date: 2026-10-17 20:41:12
+ * Copyright (c) 2024 by Panda-Young, All Rights Reserved.
+ **************************************************************************/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Keeps the data dump folder tidy from a background thread, so stopping playback never waits for the disk:
+// empty leftovers are deleted and the retention policy decides which old sessions go.
+// The decisions come from an in-memory index of the dump files. The folder is scanned once when it is first
+// set, after that only the files of each finished session are looked at, when they are added. Only files with
+// the names the plugin writes are indexed, anything else the user keeps in the folder is left alone.
+// A session is the set of files sharing a time stamp prefix; sessions are deleted as a whole, oldest first,
+// and the newest one is always kept. All plugin instances of a process dump into the same folder, so they
+// share one housekeeper through juce::SharedResourcePointer.
+class myDumpHousekeeper
+{
+public:
+    // Zero means no limit
+    struct RetentionPolicy {
+        uint64_t maxTotalBytes = 0;
+        int maxAgeDays = 0;
+        int maxFiles = 0;
+    };
+
+    myDumpHousekeeper() = default;
+    ~myDumpHousekeeper();
+
+    // Message thread. Only files last modified before the first call for a folder are picked up by its scan,
+    // so the scan never touches a session that is being written; later files come in through addFiles.
+    void setDirectory(const juce::File &directory);
+    void setPolicy(const RetentionPolicy &policy);
+    // Any thread but the audio thread. Closed dump files to add to the index with the next pass.
+    void addFiles(const juce::Array<juce::File> &files);
+    // Any thread but the audio thread. Queues a housekeeping pass and returns at once.
+    void requestCleanup();
+
+    uint64_t getIndexedBytes() const { return indexedBytes.load(std::memory_order_relaxed); }
+    int getIndexedFiles() const { return indexedFiles.load(std::memory_order_relaxed); }
+
+private:
+    struct Entry {
+        uint64_t size = 0;
+        juce::Time modified;
+    };
+
+    void startThread();
+    void housekeepingLoop();
+    void runPass();
+    void scanDirectory(const juce::File &directory, juce::Time before);
+    void indexFile(const juce::File &file);
+    void applyPolicy(const RetentionPolicy &policy);
+    static bool hasTimeStampPrefix(const juce::String &name);
+    static bool isDumpFile(const juce::File &file);
+    static std::string getSessionKey(const juce::File &file);
+
+    // guarded by requestMutex, handed over to the housekeeping thread at the start of a pass
+    std::mutex requestMutex;
+    std::condition_variable requestCondition; // signalled when a pass is queued or the thread has to stop
+    juce::File dumpDirectory;
+    juce::Time scanBefore;
+    bool scanPending = false;
+    RetentionPolicy retention;
+    juce::Array<juce::File> pendingFiles;
+    bool passPending = false;
+    bool threadRunning = false;
+
+    // housekeeping thread only
+    juce::File indexedDirectory;
+    std::map<std::string, Entry> index; // by full path
+    uint64_t totalBytes = 0;
+
+    std::atomic<uint64_t> indexedBytes{0};
+    std::atomic<int> indexedFiles{0};
+    std::thread housekeepingThread;
+
+    JUCE_DECLARE_NON_COPYABLE(myDumpHousekeeper)
+};
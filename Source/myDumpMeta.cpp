@@ -0,0 +1,130 @@
+/***************************************************************************
+ * Description: myDumpMeta
+ * version: 0.1.0
+ * Author: Panda-Young
+ * Date: 2026-10-17 19:26:05
+ * Copyright (c) 2024 by Panda-Young, All Rights Reserved.
+ **************************************************************************/
+
+#include "myDumpMeta.h"
+#include <cstring>
+
+static void putLE(uint8_t *dest, uint64_t value, int numBytes)
+{
+    for (int i = 0; i < numBytes; i++) {
+        dest[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+static uint64_t getLE(const uint8_t *src, int numBytes)
+{
+    uint64_t value = 0;
+    for (int i = 0; i < numBytes; i++) {
+        value |= static_cast<uint64_t>(src[i]) << (8 * i);
+    }
+    return value;
+}
+
+static void putFloat(uint8_t *dest, float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    putLE(dest, bits, 4);
+}
+
+static float getFloat(const uint8_t *src)
+{
+    uint32_t bits = static_cast<uint32_t>(getLE(src, 4));
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+void encodeDumpMetaFileHeader(uint8_t (&header)[kDumpMetaFileHeaderBytes], uint16_t numChannels, uint32_t sampleRate,
+                              const char *algoVersion)
+{
+    std::memset(header, 0, kDumpMetaFileHeaderBytes);
+    std::memcpy(header, "PDM2", 4);
+    putLE(header + 4, numChannels, 2);
+    putLE(header + 8, sampleRate, 4);
+    if (algoVersion != nullptr) {
+        std::strncpy(reinterpret_cast<char *>(header + 12), algoVersion, kDumpMetaVersionBytes);
+    }
+    encodeDumpMetaGainRamp(header, DumpMetaGainRamp());
+}
+
+void encodeDumpMetaGainRamp(uint8_t (&header)[kDumpMetaFileHeaderBytes], const DumpMetaGainRamp &ramp)
+{
+    putFloat(header + 32, ramp.current);
+    putFloat(header + 36, ramp.target);
+    putFloat(header + 40, ramp.step);
+    putLE(header + 44, ramp.remaining, 4);
+}
+
+bool decodeDumpMetaFileHeader(const uint8_t (&header)[kDumpMetaFileHeaderBytes], uint16_t &numChannels,
+                              uint32_t &sampleRate, char (&algoVersion)[kDumpMetaVersionBytes + 1],
+                              DumpMetaGainRamp &ramp)
+{
+    if (std::memcmp(header, "PDM2", 4) != 0) {
+        return false;
+    }
+    numChannels = static_cast<uint16_t>(getLE(header + 4, 2));
+    sampleRate = static_cast<uint32_t>(getLE(header + 8, 4));
+    std::memcpy(algoVersion, header + 12, kDumpMetaVersionBytes);
+    algoVersion[kDumpMetaVersionBytes] = '\0';
+    ramp.current = getFloat(header + 32);
+    ramp.target = getFloat(header + 36);
+    ramp.step = getFloat(header + 40);
+    ramp.remaining = static_cast<uint32_t>(getLE(header + 44, 4));
+    return numChannels > 0 && sampleRate > 0;
+}
+
+size_t encodeDumpFrameRecord(const DumpFrameRecord &record, uint8_t *dest)
+{
+    const uint32_t numEvents = record.numGainEvents < kDumpMetaMaxEvents ? record.numGainEvents : kDumpMetaMaxEvents;
+    putLE(dest, record.frameIndex, 8);
+    putLE(dest + 8, record.blockIndex, 8);
+    putLE(dest + 16, record.frameSize, 4);
+    putLE(dest + 20, record.flags, 4);
+    putFloat(dest + 24, record.gainAtStart);
+    putFloat(dest + 28, record.processMs);
+    putLE(dest + 32, static_cast<uint32_t>(record.result), 4);
+    putLE(dest + 36, numEvents, 4);
+    uint8_t *event = dest + kDumpMetaRecordBytes;
+    for (uint32_t i = 0; i < numEvents; i++, event += kDumpMetaEventBytes) {
+        putLE(event, record.gainEvents[i].offset, 4);
+        putFloat(event + 4, record.gainEvents[i].gain);
+    }
+    return kDumpMetaRecordBytes + numEvents * kDumpMetaEventBytes;
+}
+
+size_t decodeDumpFrameRecord(const uint8_t *src, size_t available, DumpFrameRecord &record)
+{
+    if (available < kDumpMetaRecordBytes) {
+        return 0;
+    }
+    record.frameIndex = getLE(src, 8);
+    record.blockIndex = getLE(src + 8, 8);
+    record.frameSize = static_cast<uint32_t>(getLE(src + 16, 4));
+    record.flags = static_cast<uint32_t>(getLE(src + 20, 4));
+    record.gainAtStart = getFloat(src + 24);
+    record.processMs = getFloat(src + 28);
+    record.result = static_cast<int32_t>(static_cast<uint32_t>(getLE(src + 32, 4)));
+    record.numGainEvents = static_cast<uint32_t>(getLE(src + 36, 4));
+    if (record.numGainEvents > kDumpMetaMaxEvents) {
+        return 0;
+    }
+    const size_t size = kDumpMetaRecordBytes + record.numGainEvents * kDumpMetaEventBytes;
+    if (available < size) {
+        return 0;
+    }
+    const uint8_t *event = src + kDumpMetaRecordBytes;
+    for (uint32_t i = 0; i < record.numGainEvents; i++, event += kDumpMetaEventBytes) {
+        record.gainEvents[i].offset = static_cast<uint32_t>(getLE(event, 4));
+        record.gainEvents[i].gain = getFloat(event + 4);
+        if (record.gainEvents[i].offset > record.frameSize) {
+            return 0;
+        }
+    }
+    return size;
+}
@@ -0,0 +1,77 @@
+/***************************************************************************
+ * Description: Header of myDumpMeta
+ * version: 0.1.0
+ * Author: Panda-Young
+ * Date: 2026-10-17 19:26:05
+ * Copyright (c) 2024 by Panda-Young, All Rights Reserved.
+ **************************************************************************/
+
+#pragma once
+
+// Sidecar of a data dump session (.pdmeta): one record per internal frame handed to the algorithm,
+// with everything needed to feed the pre-algorithm dump through algo_process again bit for bit.
+// Plain C++ so that DumpTools can read it; encoding does not allocate, the audio thread does it.
+//
+// File:   "PDM2" | uint16 channels | uint16 reserved | uint32 sample rate | char[20] algorithm version |
+//         float gain ramp current | float gain ramp target | float gain ramp step | uint32 gain ramp remaining
+// Record: uint64 frame index | uint64 host block index | uint32 frame size | uint32 flags |
+//         float gain at start (dB) | float processing time (ms) | int32 algo_process result |
+//         uint32 gain events | per event: uint32 offset | float gain (dB)
+// All fields are little endian.
+#include <cstddef>
+#include <cstdint>
+
+constexpr size_t kDumpMetaFileHeaderBytes = 48;
+constexpr size_t kDumpMetaVersionBytes = 20;
+constexpr size_t kDumpMetaRecordBytes = 40;
+constexpr size_t kDumpMetaEventBytes = 8;
+constexpr uint32_t kDumpMetaMaxEvents = 32;
+
+enum DumpMetaFlags : uint32_t {
+    kDumpMetaBypass = 1 << 0,            // not processed, only the last gain event was applied
+    kDumpMetaPreAlgoCaptured = 1 << 1,   // the frame is in the pre-algorithm dump
+    kDumpMetaPostAlgoCaptured = 1 << 2,  // the result is in the post-algorithm dump
+    kDumpMetaDoublePrecision = 1 << 3,   // processed with algo_process_multi_double
+};
+
+// Gain ramp inside the algorithm before the first frame of the file (algo_gain_ramp_t), linear gains
+struct DumpMetaGainRamp {
+    float current = 1.0f;
+    float target = 1.0f;
+    float step = 0.0f;
+    uint32_t remaining = 0;
+};
+
+// Gain change at a sample offset inside the frame, applied before the samples from there on are processed
+struct DumpMetaGainEvent {
+    uint32_t offset = 0;
+    float gain = 0.0f;
+};
+
+struct DumpFrameRecord {
+    uint64_t frameIndex = 0; // algoFrameCounter, bypassed frames keep the index of the next processed one
+    uint64_t blockIndex = 0; // host block the frame was completed in, counted from prepareToPlay
+    uint32_t frameSize = 0;
+    uint32_t flags = 0;
+    float gainAtStart = 0.0f; // gain inside the algorithm when the frame started
+    float processMs = 0.0f;
+    int32_t result = 0;
+    uint32_t numGainEvents = 0;
+    DumpMetaGainEvent gainEvents[kDumpMetaMaxEvents];
+};
+
+constexpr size_t kDumpMetaMaxRecordBytes = kDumpMetaRecordBytes + kDumpMetaMaxEvents * kDumpMetaEventBytes;
+
+// The gain ramp is left at its default, encodeDumpMetaGainRamp fills it in once the first frame is known
+void encodeDumpMetaFileHeader(uint8_t (&header)[kDumpMetaFileHeaderBytes], uint16_t numChannels, uint32_t sampleRate,
+                              const char *algoVersion);
+void encodeDumpMetaGainRamp(uint8_t (&header)[kDumpMetaFileHeaderBytes], const DumpMetaGainRamp &ramp);
+// Returns false if header is not a .pdmeta file header, algoVersion is always terminated
+bool decodeDumpMetaFileHeader(const uint8_t (&header)[kDumpMetaFileHeaderBytes], uint16_t &numChannels,
+                              uint32_t &sampleRate, char (&algoVersion)[kDumpMetaVersionBytes + 1],
+                              DumpMetaGainRamp &ramp);
+
+// Writes the record to dest (kDumpMetaMaxRecordBytes at most) and returns its size, a multiple of 4
+size_t encodeDumpFrameRecord(const DumpFrameRecord &record, uint8_t *dest);
+// Reads the record at src, returns its size, or 0 if the available bytes hold no complete valid record
+size_t decodeDumpFrameRecord(const uint8_t *src, size_t available, DumpFrameRecord &record);
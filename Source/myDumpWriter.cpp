@@ -0,0 +1,272 @@
+/***************************************************************************
+ * Description: myDumpWriter
+ * version: 0.1.0
+ * Author: Panda-Young
+ * Date: 2026-10-17 14:05:22
+ * Copyright (c) 2024 by Panda-Young, All Rights Reserved.
+ **************************************************************************/
+
+#include "myDumpWriter.h"
+#include "myLogger.h"
+
+// How long the writer sleeps when all rings are empty, and after how many idle rounds
+// a partially filled chunk is written anyway so that a stalled transport still reaches the disk
+static constexpr auto kWriterPollInterval = std::chrono::milliseconds(5);
+static constexpr int kIdleRoundsBeforeFlush = 100;
+
+myDumpWriter::~myDumpWriter()
+{
+    close();
+}
+
+int myDumpWriter::addStream(const juce::File &file, double sampleRate, int numChannels, Format format,
+                            double ringSeconds)
+{
+    if (isRunning() || numStreams == kMaxStreams) {
+        LOG_MSG(LOG_ERROR, "Cannot add data dump stream: \"" + file.getFullPathName().toStdString() + "\"");
+        return -1;
+    }
+    if (numChannels <= 0 || sampleRate <= 0) {
+        LOG_MSG(LOG_ERROR, "Invalid data dump format: sampleRate=" + std::to_string(sampleRate) +
+                               ", numChannels=" + std::to_string(numChannels));
+        return -1;
+    }
+
+    uint32_t capacity = 1 << 16;
+    const double wanted = sampleRate * numChannels * ringSeconds;
+    while (capacity < wanted && capacity < (1u << 30)) {
+        capacity <<= 1;
+    }
+
+    auto stream = std::make_unique<Stream>();
+    // whole sample frames only, the compressed format encodes each chunk on its own
+    stream->chunkSamples = kChunkBytes / sizeof(float) / static_cast<size_t>(numChannels) *
+                           static_cast<size_t>(numChannels);
+    try {
+        stream->ring = std::make_unique<float[]>(capacity);
+        stream->chunk = std::make_unique<float[]>(stream->chunkSamples);
+        if (format == Format::Compressed) {
+            const int chunkFrames = static_cast<int>(stream->chunkSamples) / numChannels;
+            stream->encodeBuffer = std::make_unique<uint8_t[]>(dumpCodecMaxBytes(numChannels, chunkFrames));
+        }
+    } catch (const std::bad_alloc &e) {
+        LOG_MSG(LOG_ERROR, "Failed to allocate data dump ring: " + std::string(e.what()));
+        return -1;
+    }
+    if (!stream->output.open(file, kChunkBytes)) {
+        return -1;
+    }
+
+    stream->file = file;
+    stream->numChannels = numChannels;
+    stream->sampleRate = sampleRate;
+    stream->format = format;
+    stream->ringCapacity = capacity;
+    if (!writeHeader(*stream)) {
+        stream->output.close();
+        return -1;
+    }
+
+    LOG_MSG(LOG_DEBUG, "Opened data dump file: \"" + file.getFullPathName().toStdString() + "\", ring of " +
+                           std::to_string(capacity) + " samples, " +
+                           myDumpFile::getBackendName(stream->output.getBackend()) +
+                           (stream->output.isDirect() ? " with O_DIRECT" : ""));
+    streams[numStreams] = std::move(stream);
+    return numStreams++;
+}
+
+bool myDumpWriter::start()
+{
+    if (isRunning() || numStreams == 0) {
+        return false;
+    }
+    writerRunning.store(true, std::memory_order_release);
+    writerThread = std::thread(&myDumpWriter::writerLoop, this);
+    return true;
+}
+
+void myDumpWriter::close()
+{
+    if (writerThread.joinable()) {
+        writerRunning.store(false, std::memory_order_release);
+        writerThread.join();
+    }
+    for (int i = 0; i < numStreams; i++) {
+        closeStream(*streams[i]);
+        streams[i].reset();
+    }
+    numStreams = 0;
+}
+
+void myDumpWriter::closeStream(Stream &stream)
+{
+    const std::string path = stream.file.getFullPathName().toStdString();
+    if (stream.output.close()) {
+        LOG_MSG(LOG_DEBUG, "Closed data dump file: \"" + path + "\", " + std::to_string(stream.bytesWritten.load()) +
+                               " bytes written");
+    }
+    const uint64_t diskBytes = stream.output.getBytesCompleted();
+    if (diskBytes > 0) {
+        const double busySeconds = stream.output.getBusySeconds();
+        const std::string backend = myDumpFile::getBackendName(stream.output.getBackend());
+        LOG_MSG(LOG_INFO, "Data dump disk writes (" + backend + (stream.output.isDirect() ? ", O_DIRECT" : "") +
+                              "): " + std::to_string(diskBytes) + " bytes in " + std::to_string(busySeconds) +
+                              " s busy, " + std::to_string(busySeconds > 0 ? diskBytes / busySeconds / 1e6 : 0.0) +
+                              " MB/s, max queue depth " + std::to_string(stream.output.getMaxQueueDepth()));
+    }
+    if (stream.format == Format::Compressed && stream.bytesWritten.load() > 0) {
+        const double audioBytes = static_cast<double>(stream.bytesWritten.load());
+        LOG_MSG(LOG_INFO, "Compressed data dump: " + std::to_string(stream.bytesWritten.load()) + " -> " +
+                              std::to_string(stream.fileBytes.load()) + " bytes, ratio " +
+                              std::to_string(audioBytes / static_cast<double>(stream.fileBytes.load())) +
+                              ", encoder throughput " +
+                              std::to_string(stream.encodeSeconds > 0 ? audioBytes / stream.encodeSeconds / 1e6 : 0.0) +
+                              " MB/s");
+    }
+    if (stream.bytesWritten.load() == 0 && stream.file.deleteFile()) {
+        LOG_MSG(LOG_DEBUG, "Deleted empty data dump file: \"" + path + "\"");
+    }
+
+    uint32_t overruns = stream.overrunFrames.load();
+    if (overruns > 0) {
+        LOG_MSG(LOG_WARN, "Data dump ring overrun, dropped " + std::to_string(overruns) + " frames of \"" + path +
+                              "\"");
+    }
+}
+
+void myDumpWriter::writeChunk(Stream &stream, size_t numBytes)
+{
+    if (numBytes == 0 || stream.writeFailed) {
+        return;
+    }
+    bool written;
+    if (stream.format == Format::Compressed) {
+        auto encodeStart = std::chrono::steady_clock::now();
+        const int numFrames = static_cast<int>(numBytes / sizeof(float)) / stream.numChannels;
+        size_t encodedBytes = encodeDumpFrames(stream.chunk.get(), stream.numChannels, numFrames,
+                                               stream.encodeBuffer.get());
+        stream.encodeSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - encodeStart).count();
+        written = writeToFile(stream, stream.encodeBuffer.get(), encodedBytes);
+    } else {
+        written = writeToFile(stream, stream.chunk.get(), numBytes);
+    }
+    if (written) {
+        stream.bytesWritten.fetch_add(numBytes, std::memory_order_relaxed);
+    }
+}
+
+bool myDumpWriter::writeToFile(Stream &stream, const void *data, size_t numBytes)
+{
+    if (!stream.output.append(data, numBytes)) {
+        // keep draining the ring so the audio thread is never blocked, but stop touching the disk,
+        // myDumpFile has logged the reason
+        stream.writeFailed = true;
+        return false;
+    }
+    stream.fileBytes.fetch_add(numBytes, std::memory_order_relaxed);
+    return true;
+}
+
+bool myDumpWriter::writeHeader(Stream &stream)
+{
+    if (stream.writeFailed) {
+        return false;
+    }
+    if (stream.format == Format::Raw) {
+        return true;
+    }
+    if (stream.format == Format::Compressed) {
+        // the blocks are self-delimiting, so only the file header is written, once
+        if (stream.fileBytes.load(std::memory_order_relaxed) > 0) {
+            return true;
+        }
+        uint8_t codecHeader[kDumpCodecFileHeaderBytes];
+        encodeDumpFileHeader(codecHeader, static_cast<uint16_t>(stream.numChannels),
+                             static_cast<uint32_t>(stream.sampleRate));
+        return writeToFile(stream, codecHeader, kDumpCodecFileHeaderBytes);
+    }
+    uint8_t header[kWavHeaderBytes];
+    buildWavHeader(header, static_cast<uint16_t>(stream.numChannels), static_cast<uint32_t>(stream.sampleRate), 32,
+                   kWavFormatIEEEFloat, stream.bytesWritten.load(std::memory_order_relaxed));
+    if (stream.fileBytes.load(std::memory_order_relaxed) == 0) {
+        return writeToFile(stream, header, kWavHeaderBytes);
+    }
+    if (!stream.output.overwriteHead(header, kWavHeaderBytes)) {
+        stream.writeFailed = true;
+        return false;
+    }
+    return true;
+}
+
+bool myDumpWriter::drainStream(Stream &stream)
+{
+    uint32_t tail = stream.ringTail.load(std::memory_order_relaxed);
+    uint32_t head = stream.ringHead.load(std::memory_order_acquire);
+    uint32_t available = head - tail;
+    if (available == 0) {
+        return false;
+    }
+    stream.idleRounds = 0;
+
+    float *stage = stream.chunk.get();
+    const uint32_t mask = stream.ringCapacity - 1;
+    uint32_t count = static_cast<uint32_t>(juce::jmin<size_t>(available, stream.chunkSamples - stream.staged));
+    const uint32_t start = tail & mask;
+    const uint32_t first = juce::jmin(count, stream.ringCapacity - start);
+    std::memcpy(stage + stream.staged, stream.ring.get() + start, first * sizeof(float));
+    std::memcpy(stage + stream.staged + first, stream.ring.get(), (count - first) * sizeof(float));
+    stream.ringTail.store(tail + count, std::memory_order_release);
+
+    stream.staged += count;
+    if (stream.staged == stream.chunkSamples) {
+        writeChunk(stream, stream.chunkSamples * sizeof(float));
+        stream.staged = 0;
+        if (++stream.chunksSinceCheckpoint >= kChunksPerCheckpoint) {
+            writeHeader(stream);
+            stream.chunksSinceCheckpoint = 0;
+        }
+    }
+    return true;
+}
+
+void myDumpWriter::flushIdleStream(Stream &stream)
+{
+    if (stream.staged > 0 && ++stream.idleRounds >= kIdleRoundsBeforeFlush) {
+        writeChunk(stream, stream.staged * sizeof(float));
+        writeHeader(stream);
+        // a stalled transport should still find everything on the disk
+        if (!stream.writeFailed) {
+            stream.output.flush();
+        }
+        stream.staged = 0;
+        stream.idleRounds = 0;
+        stream.chunksSinceCheckpoint = 0;
+    }
+}
+
+void myDumpWriter::writerLoop()
+{
+    for (;;) {
+        const bool running = writerRunning.load(std::memory_order_acquire);
+        bool busy = false;
+        for (int i = 0; i < numStreams; i++) {
+            busy |= drainStream(*streams[i]);
+        }
+        if (busy) {
+            continue;
+        }
+        if (!running) {
+            break;
+        }
+        for (int i = 0; i < numStreams; i++) {
+            flushIdleStream(*streams[i]);
+        }
+        std::this_thread::sleep_for(kWriterPollInterval);
+    }
+
+    for (int i = 0; i < numStreams; i++) {
+        writeChunk(*streams[i], streams[i]->staged * sizeof(float));
+        streams[i]->staged = 0;
+        writeHeader(*streams[i]);
+    }
+}
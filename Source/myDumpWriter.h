@@ -0,0 +1,195 @@
+/***************************************************************************
+ * Description: Header of myDumpWriter
+ * version: 0.1.0
+ * Author: Panda-Young
+ * Date: 2026-10-17 14:05:22
+ * Copyright (c) 2024 by Panda-Young, All Rights Reserved.
+ **************************************************************************/
+
+#pragma once
+
+#include "myDumpCodec.h"
+#include "myDumpFile.h"
+#include "myUtils.h"
+#include "myWavFile.h"
+#include <JuceHeader.h>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <thread>
+
+// Streams data dump frames to 32-bit float WAV files from one background thread.
+// Each stream (one per capture point) has its own file and preallocated lock-free ring (single producer,
+// single consumer); the audio thread only copies frames into the rings and the writer thread drains all
+// of them, writing large chunks through myDumpFile (io_uring and O_DIRECT on Linux). A frame that does
+// not fit into its ring is dropped and counted as an overrun, never waited for.
+// The header is written up front and its sizes are patched at checkpoints and on close, so a file is
+// playable while it grows, and it switches to RF64 past 4 GB (see buildWavHeader).
+// In the compressed format the writer thread encodes each chunk losslessly (see myDumpCodec) before writing it.
+// A raw stream carries byte records instead of audio, such as the frame sidecar (see myDumpMeta), and has no
+// header of its own.
+class myDumpWriter
+{
+public:
+    enum class Format {
+        Wav,
+        Compressed,
+        Raw
+    };
+    static constexpr int kMaxStreams = 5; // the four capture points and their frame sidecar
+
+    myDumpWriter() = default;
+    ~myDumpWriter();
+
+    // Message thread, before start(). Allocates the ring for ringSeconds of audio and opens the file,
+    // returns the stream index for pushFrame or -1 on failure.
+    int addStream(const juce::File &file, double sampleRate, int numChannels, Format format = Format::Wav,
+                  double ringSeconds = 2.0);
+    // Message thread. Starts the writer thread shared by all streams added so far.
+    bool start();
+    // Message thread. Writes everything still queued, closes the files and stops the writer.
+    void close();
+    bool isRunning() const { return writerRunning.load(std::memory_order_acquire); }
+
+    // Audio thread. Queues one frame interleaved and converted to 32-bit float, all or nothing.
+    template <typename SampleType>
+    bool pushFrame(int stream, const SampleType *const *channels, int numChannels, int numSamples)
+    {
+        if (!isRunning() || stream < 0 || stream >= numStreams || numSamples <= 0) {
+            return false;
+        }
+        return streams[stream]->push(channels, numChannels, numSamples);
+    }
+
+    // Audio thread. Queues a record of a raw stream, numBytes must be a multiple of 4, all or nothing.
+    bool pushRecord(int stream, const void *data, size_t numBytes)
+    {
+        if (!isRunning() || stream < 0 || stream >= numStreams || numBytes == 0 || numBytes % sizeof(float) != 0) {
+            return false;
+        }
+        return streams[stream]->pushBytes(static_cast<const uint8_t *>(data), numBytes);
+    }
+
+    const juce::File &getFile(int stream) const { return streams[stream]->file; }
+    uint32_t getOverrunFrames(int stream) const
+    {
+        return streams[stream]->overrunFrames.load(std::memory_order_relaxed);
+    }
+    // Audio bytes taken from the ring, and what reached the file for them
+    uint64_t getBytesWritten(int stream) const
+    {
+        return streams[stream]->bytesWritten.load(std::memory_order_relaxed);
+    }
+    uint64_t getFileBytes(int stream) const { return streams[stream]->fileBytes.load(std::memory_order_relaxed); }
+    // Writes currently queued to the disk, and the most there were at once
+    int getQueueDepth(int stream) const { return streams[stream]->output.getQueueDepth(); }
+    int getMaxQueueDepth(int stream) const { return streams[stream]->output.getMaxQueueDepth(); }
+    // Bytes per second while the disk was busy with the stream
+    double getThroughput(int stream) const
+    {
+        const double busySeconds = streams[stream]->output.getBusySeconds();
+        return busySeconds > 0 ? static_cast<double>(streams[stream]->output.getBytesCompleted()) / busySeconds : 0.0;
+    }
+
+private:
+    struct Stream {
+        juce::File file;
+        myDumpFile output;
+        int numChannels = 0;
+        double sampleRate = 0;
+        Format format = Format::Wav;
+
+        std::unique_ptr<float[]> ring;
+        uint32_t ringCapacity = 0; // power of two, in samples
+        std::atomic<uint32_t> ringHead{0};
+        std::atomic<uint32_t> ringTail{0};
+
+        // writer thread only
+        std::unique_ptr<float[]> chunk;
+        size_t chunkSamples = 0;
+        size_t staged = 0;
+        int idleRounds = 0;
+        int chunksSinceCheckpoint = 0;
+        std::unique_ptr<uint8_t[]> encodeBuffer;
+        double encodeSeconds = 0;
+        bool writeFailed = false;
+
+        std::atomic<uint32_t> overrunFrames{0};
+        std::atomic<uint64_t> bytesWritten{0};
+        std::atomic<uint64_t> fileBytes{0};
+
+        template <typename SampleType>
+        bool push(const SampleType *const *channels, int pushChannels, int numSamples)
+        {
+            pushChannels = juce::jmin(pushChannels, numChannels);
+            const uint32_t needed = static_cast<uint32_t>(pushChannels * numSamples);
+            uint32_t head = ringHead.load(std::memory_order_relaxed);
+            uint32_t tail = ringTail.load(std::memory_order_acquire);
+            if (needed > ringCapacity - (head - tail)) {
+                overrunFrames.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            writeInterleaved(head, channels, pushChannels, numSamples);
+            ringHead.store(head + needed, std::memory_order_release);
+            return true;
+        }
+
+        bool pushBytes(const uint8_t *data, size_t numBytes)
+        {
+            const uint32_t needed = static_cast<uint32_t>(numBytes / sizeof(float));
+            uint32_t head = ringHead.load(std::memory_order_relaxed);
+            uint32_t tail = ringTail.load(std::memory_order_acquire);
+            if (needed > ringCapacity - (head - tail)) {
+                overrunFrames.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            const uint32_t start = head & (ringCapacity - 1);
+            const uint32_t first = juce::jmin(needed, ringCapacity - start);
+            std::memcpy(ring.get() + start, data, first * sizeof(float));
+            std::memcpy(ring.get(), data + first * sizeof(float), (needed - first) * sizeof(float));
+            ringHead.store(head + needed, std::memory_order_release);
+            return true;
+        }
+
+        template <typename SampleType>
+        void writeInterleaved(uint32_t position, const SampleType *const *channels, int pushChannels,
+                              int numSamples)
+        {
+            int done = 0;
+            while (done < numSamples) {
+                const uint32_t start = (position + static_cast<uint32_t>(done * pushChannels)) & (ringCapacity - 1);
+                const int fit = static_cast<int>((ringCapacity - start) / static_cast<uint32_t>(pushChannels));
+                if (fit == 0) {
+                    // this sample frame straddles the end of the ring, only possible with an odd channel count
+                    for (int channel = 0; channel < pushChannels; channel++) {
+                        ring[(start + static_cast<uint32_t>(channel)) & (ringCapacity - 1)] =
+                            static_cast<float>(channels[channel][done]);
+                    }
+                    done++;
+                    continue;
+                }
+                const int count = juce::jmin(fit, numSamples - done);
+                interleaveSamples(channels, pushChannels, done, count, ring.get() + start);
+                done += count;
+            }
+        }
+    };
+
+    void writerLoop();
+    bool drainStream(Stream &stream);
+    void flushIdleStream(Stream &stream);
+    void writeChunk(Stream &stream, size_t numBytes);
+    bool writeHeader(Stream &stream);
+    bool writeToFile(Stream &stream, const void *data, size_t numBytes);
+    void closeStream(Stream &stream);
+
+    static constexpr size_t kChunkBytes = 1 << 20;
+    static constexpr int kChunksPerCheckpoint = 32; // header sizes are patched at least every 32 MiB
+
+    std::unique_ptr<Stream> streams[kMaxStreams];
+    int numStreams = 0;
+    std::atomic<bool> writerRunning{false};
+    std::thread writerThread;
+
+    JUCE_DECLARE_NON_COPYABLE(myDumpWriter)
+};
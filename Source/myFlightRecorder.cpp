@@ -0,0 +1,209 @@
+/***************************************************************************
+ * Description: myFlightRecorder
+ * version: 0.1.0
+ * Author: Panda-Young
+ * Date: 2026-10-17 17:03:26
+ * Copyright (c) 2024 by Panda-Young, All Rights Reserved.
+ **************************************************************************/
+
+#include "myFlightRecorder.h"
+#include "myLogger.h"
+#include "myWavFile.h"
+#include <chrono>
+#include <cstring>
+#include <ctime>
+
+// How often the flush thread looks for a trigger, and how much more history the ring holds than is saved
+static constexpr auto kFlushPollInterval = std::chrono::milliseconds(10);
+static constexpr double kCopyMarginSeconds = 1.0;
+
+static const char *const kTrackNames[myFlightRecorder::NumTracks] = {"input", "output"};
+
+myFlightRecorder::~myFlightRecorder()
+{
+    release();
+}
+
+const char *myFlightRecorder::getTriggerName(Trigger reason)
+{
+    switch (reason) {
+    case Trigger::AlgoError:
+        return "algo_error";
+    case Trigger::BadSample:
+        return "bad_sample";
+    case Trigger::DeadlineMiss:
+        return "deadline_miss";
+    case Trigger::Request:
+        return "request";
+    case Trigger::Clipping:
+        return "clipping";
+    default:
+        return "none";
+    }
+}
+
+bool myFlightRecorder::prepare(const juce::File &directory, double sampleRate, int channels, double seconds)
+{
+    release();
+    if (channels <= 0 || sampleRate <= 0 || seconds <= 0) {
+        LOG_MSG(LOG_ERROR, "Invalid flight recorder format: sampleRate=" + std::to_string(sampleRate) +
+                               ", numChannels=" + std::to_string(channels));
+        return false;
+    }
+
+    historyFrames = static_cast<int>(sampleRate * seconds);
+    capacityFrames = historyFrames + static_cast<int>(sampleRate * kCopyMarginSeconds);
+    const size_t capacitySamples = static_cast<size_t>(capacityFrames) * static_cast<size_t>(channels);
+    const size_t historySamples = static_cast<size_t>(historyFrames) * static_cast<size_t>(channels);
+    try {
+        for (auto &history : histories) {
+            history.ring = std::make_unique<float[]>(capacitySamples);
+            history.snapshot = std::make_unique<float[]>(historySamples);
+            history.writeFrame = 0;
+            history.framesWritten.store(0, std::memory_order_relaxed);
+        }
+    } catch (const std::bad_alloc &e) {
+        LOG_MSG(LOG_ERROR, "Failed to allocate flight recorder history: " + std::string(e.what()));
+        for (auto &history : histories) {
+            history.ring.reset();
+            history.snapshot.reset();
+        }
+        return false;
+    }
+
+    outputDirectory = directory;
+    recordSampleRate = sampleRate;
+    numChannels = channels;
+    windowFrames = 0;
+    clippedFrames = 0;
+    clipRecordingsLeft = kMaxClipRecordings;
+    pendingTrigger.store(Trigger::None, std::memory_order_relaxed);
+    flushRunning.store(true, std::memory_order_release);
+    flushThread = std::thread(&myFlightRecorder::flushLoop, this);
+    LOG_MSG(LOG_DEBUG, "Flight recorder keeps the last " + std::to_string(seconds) + " s of " +
+                           std::to_string(channels) + " channels");
+    return true;
+}
+
+void myFlightRecorder::release()
+{
+    if (flushThread.joinable()) {
+        flushRunning.store(false, std::memory_order_release);
+        flushThread.join();
+    }
+    for (auto &history : histories) {
+        history.ring.reset();
+        history.snapshot.reset();
+    }
+}
+
+juce::Array<juce::File> myFlightRecorder::takeSavedFiles()
+{
+    std::lock_guard<std::mutex> lock(savedFilesMutex);
+    juce::Array<juce::File> files;
+    files.swapWith(savedFiles);
+    return files;
+}
+
+void myFlightRecorder::flushLoop()
+{
+    for (;;) {
+        const bool running = flushRunning.load(std::memory_order_acquire);
+        const Trigger reason = pendingTrigger.load(std::memory_order_acquire);
+        if (reason != Trigger::None) {
+            flush(reason);
+            // Hold off until a whole new history has been recorded, the trigger stays latched meanwhile
+            // so that a burst of bad blocks produces one recording instead of many overlapping ones
+            const uint64_t flushedAt = histories[TrackOutput].framesWritten.load(std::memory_order_acquire);
+            while (flushRunning.load(std::memory_order_acquire) &&
+                   histories[TrackOutput].framesWritten.load(std::memory_order_acquire) - flushedAt <
+                       static_cast<uint64_t>(historyFrames)) {
+                std::this_thread::sleep_for(kFlushPollInterval);
+            }
+            pendingTrigger.store(Trigger::None, std::memory_order_release);
+            continue;
+        }
+        if (!running) {
+            break;
+        }
+        std::this_thread::sleep_for(kFlushPollInterval);
+    }
+}
+
+int myFlightRecorder::copyHistory(History &history)
+{
+    const uint64_t written = history.framesWritten.load(std::memory_order_acquire);
+    const int numFrames = static_cast<int>(juce::jmin<uint64_t>(written, static_cast<uint64_t>(historyFrames)));
+    if (numFrames == 0) {
+        return 0;
+    }
+    const int end = static_cast<int>(written % static_cast<uint64_t>(capacityFrames));
+    const int start = (end - numFrames + capacityFrames) % capacityFrames;
+    const int first = juce::jmin(numFrames, capacityFrames - start);
+    const size_t frameSamples = static_cast<size_t>(numChannels);
+    std::memcpy(history.snapshot.get(), history.ring.get() + start * frameSamples,
+                first * frameSamples * sizeof(float));
+    std::memcpy(history.snapshot.get() + first * frameSamples, history.ring.get(),
+                (numFrames - first) * frameSamples * sizeof(float));
+
+    // The audio thread writes ahead of the copied range, it only reaches the oldest copied frames
+    // after using up the margin, which a flush never takes as long as unless the disk stalls
+    const uint64_t advanced = history.framesWritten.load(std::memory_order_acquire) - written;
+    if (advanced > static_cast<uint64_t>(capacityFrames - historyFrames)) {
+        LOG_MSG(LOG_WARN, "Flight recorder history was overwritten while copying it, dropped the recording");
+        return 0;
+    }
+    return numFrames;
+}
+
+bool myFlightRecorder::writeWav(const juce::File &file, const float *samples, int numFrames)
+{
+    const std::string path = file.getFullPathName().toStdString();
+    FILE *filePtr = fopen(file.getFullPathName().toUTF8(), "wb");
+    if (filePtr == nullptr) {
+        LOG_MSG(LOG_ERROR, "Failed to open flight recording: \"" + path + "\"");
+        return false;
+    }
+    const size_t dataBytes = static_cast<size_t>(numFrames) * static_cast<size_t>(numChannels) * sizeof(float);
+    uint8_t header[kWavHeaderBytes];
+    buildWavHeader(header, static_cast<uint16_t>(numChannels), static_cast<uint32_t>(recordSampleRate), 32,
+                   kWavFormatIEEEFloat, dataBytes);
+    bool written = fwrite(header, 1, kWavHeaderBytes, filePtr) == kWavHeaderBytes &&
+                   fwrite(samples, 1, dataBytes, filePtr) == dataBytes;
+    if (fclose(filePtr) != 0) {
+        written = false;
+    }
+    if (!written) {
+        LOG_MSG(LOG_ERROR, "Failed to write flight recording: \"" + path + "\". Reason: " +
+                               std::string(strerror(errno)));
+    }
+    return written;
+}
+
+void myFlightRecorder::flush(Trigger reason)
+{
+    auto now = std::chrono::system_clock::now();
+    std::time_t now_time = std::chrono::system_clock::to_time_t(now);
+    char timeStr[20] = {0};
+    std::strftime(timeStr, sizeof(timeStr), "%Y-%m-%d_%H%M%S_", std::localtime(&now_time));
+    const juce::String prefix = juce::String(timeStr) + "flight_" + getTriggerName(reason) + "_";
+
+    for (int track = 0; track < NumTracks; track++) {
+        const int numFrames = copyHistory(histories[track]);
+        if (numFrames == 0) {
+            continue;
+        }
+        juce::File file = outputDirectory.getChildFile(prefix + kTrackNames[track] + ".wav");
+        // the housekeeping removes the folder while it is empty
+        outputDirectory.createDirectory();
+        if (writeWav(file, histories[track].snapshot.get(), numFrames)) {
+            {
+                std::lock_guard<std::mutex> lock(savedFilesMutex);
+                savedFiles.add(file);
+            }
+            LOG_MSG(LOG_INFO, "Flight recorder triggered by " + std::string(getTriggerName(reason)) + ", saved " +
+                                  std::to_string(numFrames / recordSampleRate) + " s to \"" +
+                                  file.getFullPathName().toStdString() + "\"");
+        }
+    }
+}
@@ -0,0 +1,151 @@
+/***************************************************************************
+ * Description: Header of myFlightRecorder
+ * version: 0.1.0
+ * Author: Panda-Young
+ * Date: 2026-10-17 17:03:26
+ * Copyright (c) 2024 by Panda-Young, All Rights Reserved.
+ **************************************************************************/
+
+#pragma once
+
+#include "myUtils.h"
+#include <JuceHeader.h>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Keeps the last few seconds of the host input and output in memory and writes them to WAV files only
+// when something goes wrong, so a post-mortem recording costs no disk I/O in the steady state.
+// The audio thread overwrites a preallocated history ring per track and raises triggers with a single
+// compare-and-swap; a background thread polls for them, copies the history out and writes the files.
+// The ring holds one second more than what is saved, so the copy can never be overtaken by the audio thread.
+class myFlightRecorder
+{
+public:
+    enum class Trigger {
+        None = 0,
+        AlgoError,    // algo_process returned an error
+        BadSample,    // NaN or inf in the output
+        DeadlineMiss, // a frame took longer to process than it lasts
+        Request,      // asked for by the UI or an API caller
+        Clipping,     // sustained clipping in the output, at most kMaxClipRecordings a session
+    };
+    enum Track {
+        TrackInput = 0,
+        TrackOutput,
+        NumTracks
+    };
+
+    myFlightRecorder() = default;
+    ~myFlightRecorder();
+
+    // Message thread. Preallocates the history and the snapshot buffers and starts the flush thread.
+    bool prepare(const juce::File &directory, double sampleRate, int channels, double seconds);
+    // Message thread. Finishes a pending flush and frees the buffers.
+    void release();
+    bool isPrepared() const { return flushRunning.load(std::memory_order_acquire); }
+
+    // Audio thread. Appends the samples to the history of the track, the output is checked for bad samples.
+    // Blocks with fewer channels than prepared for (a layout change without a new prepare) are skipped.
+    template <typename SampleType>
+    void record(Track track, const SampleType *const *channels, int recordChannels, int numSamples)
+    {
+        if (!isPrepared() || recordChannels < numChannels || numSamples <= 0) {
+            return;
+        }
+        History &history = histories[track];
+        int done = 0;
+        while (done < numSamples) {
+            const int count = juce::jmin(numSamples - done, capacityFrames - history.writeFrame);
+            float *dest = history.ring.get() + static_cast<size_t>(history.writeFrame) * numChannels;
+            interleaveSamples(channels, numChannels, done, count, dest);
+            if (track == TrackOutput) {
+                checkSamples(dest, count);
+            }
+            history.writeFrame = (history.writeFrame + count) % capacityFrames;
+            done += count;
+        }
+        history.framesWritten.store(history.framesWritten.load(std::memory_order_relaxed) + numSamples,
+                                    std::memory_order_release);
+    }
+
+    // Any thread, lock-free. The first trigger wins until it has been flushed; later ones are dropped while
+    // the hold-off lasts, so that consecutive recordings never overlap. Returns false if it was dropped.
+    bool trigger(Trigger reason)
+    {
+        Trigger expected = Trigger::None;
+        return pendingTrigger.compare_exchange_strong(expected, reason, std::memory_order_acq_rel);
+    }
+
+    static const char *getTriggerName(Trigger reason);
+    // Any thread but the audio thread. Hands over the recordings written since the last call.
+    juce::Array<juce::File> takeSavedFiles();
+
+private:
+    struct History {
+        std::unique_ptr<float[]> ring; // capacityFrames interleaved frames
+        int writeFrame = 0;            // audio thread only
+        std::atomic<uint64_t> framesWritten{0};
+        std::unique_ptr<float[]> snapshot; // historyFrames interleaved frames, flush thread only
+    };
+
+    // Overs are part of normal use, so clipping only counts when a large part of a window of kClipWindowFrames
+    // frames is well beyond full scale
+    void checkSamples(const float *samples, int numFrames)
+    {
+        bool bad = false;
+        bool sustainedClipping = false;
+        for (int frame = 0; frame < numFrames; frame++) {
+            bool clipped = false;
+            for (int channel = 0; channel < numChannels; channel++) {
+                const float magnitude = std::fabs(samples[frame * numChannels + channel]);
+                // also true for NaN, which fails every comparison
+                bad |= !(magnitude <= std::numeric_limits<float>::max());
+                clipped |= magnitude > kClipLevel;
+            }
+            clippedFrames += clipped ? 1 : 0;
+            if (++windowFrames == kClipWindowFrames) {
+                sustainedClipping |= clippedFrames >= kClipWindowFrames / 4;
+                windowFrames = 0;
+                clippedFrames = 0;
+            }
+        }
+        if (bad) {
+            trigger(Trigger::BadSample);
+        }
+        if (sustainedClipping && clipRecordingsLeft > 0 && trigger(Trigger::Clipping)) {
+            clipRecordingsLeft--;
+        }
+    }
+
+    void flushLoop();
+    void flush(Trigger reason);
+    int copyHistory(History &history);
+    bool writeWav(const juce::File &file, const float *samples, int numFrames);
+
+    static constexpr float kClipLevel = 2.0f;       // about +6 dBFS
+    static constexpr int kClipWindowFrames = 4800; // 100 ms at 48 kHz
+    static constexpr int kMaxClipRecordings = 3;
+
+    juce::File outputDirectory;
+    double recordSampleRate = 0;
+    int numChannels = 0;
+    int historyFrames = 0;  // what is saved on a trigger
+    int capacityFrames = 0; // historyFrames plus the copy margin
+    History histories[NumTracks];
+    int windowFrames = 0;       // audio thread only
+    int clippedFrames = 0;      // audio thread only
+    int clipRecordingsLeft = 0; // audio thread only, reset by prepare
+
+    std::mutex savedFilesMutex;
+    juce::Array<juce::File> savedFiles;
+
+    std::atomic<Trigger> pendingTrigger{Trigger::None};
+    std::atomic<bool> flushRunning{false};
+    std::thread flushThread;
+
+    JUCE_DECLARE_NON_COPYABLE(myFlightRecorder)
+};
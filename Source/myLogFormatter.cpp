@@ -0,0 +1,195 @@
+/***************************************************************************
+ * Description: myLogFormatter
+ * version: 0.1.0
+ * Author: Panda-Young
+ * Date: 2026-10-17 22:06:35
+ * Copyright (c) 2024 by Panda-Young, All Rights Reserved.
+ **************************************************************************/
+
+#include "myLogFormatter.h"
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <sstream>
+
+void myLogFormatter::append(std::string &out, std::chrono::system_clock::time_point timestamp,
+                            const std::string &threadId, const char *level, const char *file, int line,
+                            const char *function, const char *message, size_t messageLength)
+{
+    const int64_t ms = std::chrono::duration_cast<std::chrono::milliseconds>(timestamp.time_since_epoch()).count();
+    const int64_t second = ms >= 0 ? ms / 1000 : (ms - 999) / 1000;
+    if (second != cachedSecond) {
+        const std::time_t time = static_cast<std::time_t>(second);
+        std::tm localTime;
+#if defined(_WIN32)
+        localtime_s(&localTime, &time);
+#else
+        localtime_r(&time, &localTime);
+#endif
+        cachedDateTimeLength = std::strftime(cachedDateTime, sizeof(cachedDateTime), "%Y-%m-%d %H:%M:%S", &localTime);
+        cachedSecond = second;
+    }
+
+    const size_t start = out.size();
+    out.append(cachedDateTime, cachedDateTimeLength);
+    const int millisecond = static_cast<int>(ms - second * 1000);
+    out += '.';
+    out += static_cast<char>('0' + millisecond / 100);
+    out += static_cast<char>('0' + millisecond / 10 % 10);
+    out += static_cast<char>('0' + millisecond % 10);
+    out += " [";
+    out += processId;
+    out += '.';
+    out += threadId;
+    out += "] ";
+    out += level;
+    out += ' ';
+    out += file;
+    out += ':';
+    char number[16];
+    out.append(number, std::to_chars(number, number + sizeof(number), line).ptr);
+    out += " @";
+    out += function;
+    const size_t prefixLength = out.size() - start;
+    if (prefixLength < kPrefixWidth) {
+        out.append(kPrefixWidth - prefixLength, ' ');
+    }
+    out += ' ';
+    out.append(message, messageLength);
+}
+
+const std::string &myLogFormatter::getThreadIdString(std::thread::id threadId)
+{
+    auto found = threadIds.find(threadId);
+    if (found != threadIds.end()) {
+        return found->second;
+    }
+    if (threadIds.size() >= kMaxCachedThreads) {
+        // hosts that keep creating threads, start over rather than grow without bound
+        threadIds.clear();
+    }
+    std::ostringstream stream;
+    stream << threadId;
+    return threadIds.emplace(threadId, stream.str()).first->second;
+}
+
+const char *myLogFormatter::getLevelName(int level)
+{
+    // LogLevel_t of myLogger.h
+    switch (level) {
+    case 1:
+        return "DEBUG";
+    case 2:
+        return "INFO";
+    case 3:
+        return "WARN";
+    case 4:
+        return "ERROR";
+    default:
+        return "UNKNOWN";
+    }
+}
+
+static long long logArgAsInt(const myLogArg &arg)
+{
+    switch (arg.type) {
+    case myLogArg::UInt:
+        return static_cast<long long>(arg.u);
+    case myLogArg::Double:
+        return static_cast<long long>(arg.d);
+    case myLogArg::Pointer:
+        return static_cast<long long>(reinterpret_cast<intptr_t>(arg.p));
+    default:
+        return static_cast<long long>(arg.i);
+    }
+}
+
+static double logArgAsDouble(const myLogArg &arg)
+{
+    switch (arg.type) {
+    case myLogArg::Int:
+        return static_cast<double>(arg.i);
+    case myLogArg::UInt:
+        return static_cast<double>(arg.u);
+    case myLogArg::Double:
+        return arg.d;
+    default:
+        return 0.0;
+    }
+}
+
+void expandLogFormat(const char *format, const myLogArg *args, int numArgs, std::string &message)
+{
+    // Expand the printf-style format one conversion at a time, with the argument type the
+    // conversion asks for. Length modifiers in the format are ignored.
+    message.clear();
+    int argIndex = 0;
+    const char *p = format != nullptr ? format : "";
+    while (*p != '\0') {
+        if (*p != '%') {
+            message += *p++;
+            continue;
+        }
+        if (p[1] == '%') {
+            message += '%';
+            p += 2;
+            continue;
+        }
+        const char *specStart = p++;
+        while (*p != '\0' && strchr("-+ #0123456789.", *p) != nullptr) {
+            p++;
+        }
+        std::string spec(specStart, p);
+        while (*p != '\0' && strchr("hlLqjzt", *p) != nullptr) {
+            p++;
+        }
+        char conversion = *p;
+        if (conversion == '\0') {
+            break;
+        }
+        p++;
+        if (argIndex >= numArgs) {
+            message.append(specStart, p);
+            continue;
+        }
+
+        const myLogArg &arg = args[argIndex++];
+        char buf[64] = {0};
+        switch (conversion) {
+        case 'd':
+        case 'i':
+            snprintf(buf, sizeof(buf), (spec + "lld").c_str(), logArgAsInt(arg));
+            break;
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'o':
+            snprintf(buf, sizeof(buf), (spec + "ll" + conversion).c_str(),
+                     static_cast<unsigned long long>(logArgAsInt(arg)));
+            break;
+        case 'c':
+            snprintf(buf, sizeof(buf), (spec + "c").c_str(), static_cast<int>(logArgAsInt(arg)));
+            break;
+        case 'p':
+            snprintf(buf, sizeof(buf), (spec + "p").c_str(),
+                     arg.type == myLogArg::Pointer ? arg.p : reinterpret_cast<const void *>(logArgAsInt(arg)));
+            break;
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            snprintf(buf, sizeof(buf), (spec + conversion).c_str(), logArgAsDouble(arg));
+            break;
+        default:
+            // strings and anything else cannot be carried by a record
+            message.append(specStart, p);
+            continue;
+        }
+        message += buf;
+    }
+}
@@ -0,0 +1,68 @@
+/***************************************************************************
+ * Description: Header of myLogFormatter
+ * version: 0.1.0
+ * Author: Panda-Young
+ * Date: 2026-10-17 22:06:35
+ * Copyright (c) 2024 by Panda-Young, All Rights Reserved.
+ **************************************************************************/
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+// Renders the log lines of the logger's worker thread:
+// "2024-07-20 01:29:20.123 [pid.tid] LEVEL file:line @function", padded to kPrefixWidth, a space and the message.
+// The date and time are rendered once per second and the id of a thread once, and the line is appended to a
+// buffer of the caller, so a formatter that has warmed up does not allocate. Plain C++ so that DumpTools can
+// benchmark it. Not thread safe.
+class myLogFormatter
+{
+public:
+    static constexpr size_t kPrefixWidth = 96;
+
+    void setProcessId(const std::string &id) { processId = id; }
+    void append(std::string &out, std::chrono::system_clock::time_point timestamp, std::thread::id threadId,
+                const char *level, const char *file, int line, const char *function, const char *message,
+                size_t messageLength)
+    {
+        append(out, timestamp, getThreadIdString(threadId), level, file, line, function, message, messageLength);
+    }
+    // For threads only known by their id string, as in a decoded binary log
+    void append(std::string &out, std::chrono::system_clock::time_point timestamp, const std::string &threadId,
+                const char *level, const char *file, int line, const char *function, const char *message,
+                size_t messageLength);
+
+    static const char *getLevelName(int level);
+
+private:
+    const std::string &getThreadIdString(std::thread::id threadId);
+
+    static constexpr size_t kMaxCachedThreads = 1024;
+
+    std::string processId;
+    int64_t cachedSecond = INT64_MIN;
+    char cachedDateTime[32] = {0}; // "YYYY-mm-dd HH:MM:SS" of cachedSecond
+    size_t cachedDateTimeLength = 0;
+    std::unordered_map<std::thread::id, std::string> threadIds;
+};
+
+// Numeric argument of a realtime or binary log record
+struct myLogArg {
+    enum Type : uint8_t { Int, UInt, Double, Pointer } type = Int;
+    union {
+        int64_t i;
+        uint64_t u;
+        double d;
+        const void *p;
+    };
+    myLogArg() : i(0) {}
+};
+
+// Expands the printf-style format of a record with its arguments into message, replacing its contents.
+// Strings cannot be carried by a record, their conversions are copied as they are.
+void expandLogFormat(const char *format, const myLogArg *args, int numArgs, std::string &message);
@@ -7,8 +7,8 @@
  **************************************************************************/
 
 #include "myLogger.h"
-#include <iomanip>
-#include <sstream>
+#include <algorithm>
+#include <cmath>
 
 #if JUCE_WINDOWS
 #include <Windows.h> // for GetCurrentProcessId
@@ -16,9 +16,62 @@
 #include <unistd.h>
 #endif
 
+// Producers never wake the worker, it polls the queue and the realtime rings at this interval while idle
+static constexpr auto kWorkerPollInterval = std::chrono::milliseconds(10);
+// How often the worker looks for sites that went quiet with messages held back
+static constexpr auto kQuietSiteScanInterval = std::chrono::seconds(1);
+
+// The state of a call site is plain C, producers and the worker access its fields through these views
+template <typename T>
+static std::atomic<T> &siteAtomic(T &field)
+{
+    static_assert(sizeof(std::atomic<T>) == sizeof(T) && alignof(std::atomic<T>) == alignof(T) &&
+                      std::atomic<T>::is_always_lock_free,
+                  "the call site state must be usable as lock-free atomics");
+    return *reinterpret_cast<std::atomic<T> *>(&field);
+}
+
+static int64_t steadyMicros()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// FNV-1a, tells a repeated message from a new one
+static uint64_t hashBytes(const void *data, size_t length, uint64_t hash = 14695981039346656037ull)
+{
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+static uint64_t hashRtArgs(const myLogArg *args, int numArgs)
+{
+    uint64_t hash = hashBytes(&numArgs, sizeof(numArgs));
+    for (int i = 0; i < numArgs; i++) {
+        hash = hashBytes(&args[i].type, sizeof(args[i].type), hash);
+        hash = hashBytes(&args[i].u, sizeof(args[i].u), hash);
+    }
+    return hash;
+}
+
 myLogger::myLogger()
     : currentLogLevel(LOG_INFO)
 {
+    rtRings = std::make_unique<RtLogRing[]>(kMaxRtRings);
+    logSlots = std::make_unique<LogSlot[]>(kQueueCapacity);
+    for (uint32_t i = 0; i < kQueueCapacity; i++) {
+        logSlots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    messageSlab = std::make_unique<char[]>(kQueueCapacity * kSlabSlotBytes);
+    // DEBUG is left alone, whoever turns it on wants to see everything
+    setRateLimit(LOG_DEBUG, RateLimit());
+    setRateLimit(LOG_INFO, {50.0, 100, true});
+    setRateLimit(LOG_WARN, {10.0, 20, true});
+    setRateLimit(LOG_ERROR, {10.0, 20, true});
     initializeLogger();
     if (fileLogger != nullptr) {
         workerRunning.store(true, std::memory_order_relaxed);
@@ -28,8 +81,7 @@ myLogger::myLogger()
 
 myLogger::~myLogger()
 {
-    workerRunning.store(false, std::memory_order_relaxed);
-    queueCv.notify_all();
+    workerRunning.store(false, std::memory_order_release);
     if (workerThread.joinable()) {
         workerThread.join();
     }
@@ -54,133 +106,500 @@ void myLogger::initializeLogger()
 #else
     processIdString = std::to_string(getpid());
 #endif
+    formatter.setProcessId(processIdString);
+    logBatch.reserve(kMaxBatchBytes + 4096);
 }
 
-void myLogger::logMsg(LogLevel_t level, const std::string &message, const char *file, const char *function, int line)
+void myLogger::logMsg(LogLevel_t level, const std::string &message, const char *file, const char *function, int line,
+                      LogSite_t *site)
 {
     if (level < currentLogLevel.load(std::memory_order_relaxed) || fileLogger == nullptr) {
         return;
     }
+    uint32_t repeated = 0, limited = 0;
+    if (site != nullptr && !admitSite(level, site, hashBytes(message.data(), message.size()), repeated, limited)) {
+        return;
+    }
 
-    LogEntry entry;
-    entry.timestamp = std::chrono::system_clock::now();
-    entry.threadId = std::this_thread::get_id();
-    entry.level = level;
-    entry.file = (file != nullptr) ? file : "unknown_file";
-    entry.function = (function != nullptr) ? function : "unknown_function";
-    entry.line = line;
-    entry.message = message;
-
-    {
-        std::lock_guard<std::mutex> lock(queueMutex);
-        if (logQueue.size() >= kMaxQueueSize) {
-            ++droppedLogCount;
+    // A message takes consecutive slots, so the one it ends in decides whether they are all free: the worker
+    // frees slots in order
+    const bool truncated = message.size() > kMaxMessageSlots * kSlabSlotBytes;
+    const size_t length = truncated ? kMaxMessageSlots * kSlabSlotBytes : message.size();
+    const uint32_t numSlots = length == 0 ? 1 : static_cast<uint32_t>((length + kSlabSlotBytes - 1) / kSlabSlotBytes);
+    uint64_t position = enqueuePosition.load(std::memory_order_relaxed);
+    for (;;) {
+        const uint64_t last = position + numSlots - 1;
+        const uint64_t sequence = logSlots[last & (kQueueCapacity - 1)].sequence.load(std::memory_order_acquire);
+        const int64_t lag = static_cast<int64_t>(sequence - last);
+        if (lag == 0) {
+            if (enqueuePosition.compare_exchange_weak(position, position + numSlots, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (lag < 0) {
+            // the worker is a whole queue behind, what the site held back is lost with the message
+            droppedLogCount.fetch_add(1 + repeated + limited, std::memory_order_relaxed);
             return;
+        } else {
+            position = enqueuePosition.load(std::memory_order_relaxed);
         }
-        logQueue.emplace_back(std::move(entry));
     }
 
-    queueCv.notify_one();
+    LogSlot &slot = logSlots[position & (kQueueCapacity - 1)];
+    slot.timestamp = std::chrono::system_clock::now();
+    slot.threadId = std::this_thread::get_id();
+    slot.level = level;
+    slot.file = (file != nullptr) ? file : "unknown_file";
+    slot.function = (function != nullptr) ? function : "unknown_function";
+    slot.line = line;
+    slot.numSlots = numSlots;
+    slot.length = static_cast<uint32_t>(length);
+    slot.truncated = truncated;
+    slot.repeated = repeated;
+    slot.limited = limited;
+    const size_t slabBytes = kQueueCapacity * kSlabSlotBytes;
+    const size_t offset = (position & (kQueueCapacity - 1)) * kSlabSlotBytes;
+    const size_t first = std::min(length, slabBytes - offset);
+    std::memcpy(messageSlab.get() + offset, message.data(), first);
+    std::memcpy(messageSlab.get(), message.data() + first, length - first);
+
+    // the first slot goes last, once the worker sees it the whole message is there
+    for (uint32_t i = numSlots; i-- > 0;) {
+        logSlots[(position + i) & (kQueueCapacity - 1)].sequence.store(position + i + 1, std::memory_order_release);
+    }
 }
 
-const char *myLogger::levelToString(LogLevel_t level) const
+bool myLogger::drainQueue()
 {
-    switch (level) {
-    case LOG_DEBUG:
-        return "DEBUG";
-    case LOG_INFO:
-        return "INFO";
-    case LOG_WARN:
-        return "WARN";
-    case LOG_ERROR:
-        return "ERROR";
-    default:
-        return "UNKNOWN";
+    bool drained = false;
+    const size_t slabBytes = kQueueCapacity * kSlabSlotBytes;
+    LogEntry entry;
+    for (;;) {
+        LogSlot &slot = logSlots[dequeuePosition & (kQueueCapacity - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != dequeuePosition + 1) {
+            break;
+        }
+        entry.timestamp = slot.timestamp;
+        entry.threadId = slot.threadId;
+        entry.level = slot.level;
+        entry.file = slot.file;
+        entry.function = slot.function;
+        entry.line = slot.line;
+        const size_t offset = (dequeuePosition & (kQueueCapacity - 1)) * kSlabSlotBytes;
+        const size_t first = std::min<size_t>(slot.length, slabBytes - offset);
+        entry.message.assign(messageSlab.get() + offset, first);
+        entry.message.append(messageSlab.get(), slot.length - first);
+        if (slot.truncated) {
+            entry.message += " [truncated]";
+        }
+        entry.repeated = slot.repeated;
+        entry.limited = slot.limited;
+        const uint32_t numSlots = slot.numSlots;
+        for (uint32_t i = 0; i < numSlots; i++) {
+            logSlots[(dequeuePosition + i) & (kQueueCapacity - 1)].sequence.store(
+                dequeuePosition + i + kQueueCapacity, std::memory_order_release);
+        }
+        dequeuePosition += numSlots;
+        writeHeldBackReport(entry);
+        writeLogEntry(entry);
+        drained = true;
     }
+    return drained;
 }
 
-std::string myLogger::formatLogMessage(const LogEntry &entry) const
+myLogger::RtLogRing *myLogger::claimRtRing()
 {
-    auto now_time_t = std::chrono::system_clock::to_time_t(entry.timestamp);
-    auto now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(entry.timestamp.time_since_epoch()) % 1000;
-    std::tm now_tm;
-#if JUCE_WINDOWS
-    localtime_s(&now_tm, &now_time_t);
-#else
-    localtime_r(&now_time_t, &now_tm);
-#endif
+    // hands the ring back when the thread exits, so short lived threads do not use up all the rings
+    struct RingOwner {
+        RtLogRing *ring = nullptr;
+        ~RingOwner()
+        {
+            if (ring != nullptr) {
+                ring->released.store(true, std::memory_order_release);
+            }
+        }
+    };
+    thread_local RingOwner owner;
+    if (owner.ring != nullptr) {
+        return owner.ring;
+    }
+    for (int i = 0; i < kMaxRtRings; i++) {
+        bool expected = false;
+        if (rtRings[i].claimed.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+            rtRings[i].owner = std::this_thread::get_id();
+            owner.ring = &rtRings[i];
+            break;
+        }
+    }
+    return owner.ring;
+}
 
-    std::ostringstream timestamp;
-    timestamp << std::put_time(&now_tm, "%Y-%m-%d %H:%M:%S") << '.' << std::setfill('0') << std::setw(3) << now_ms.count();
+void myLogger::pushRtRecord(LogLevel_t level, LogSite_t *site, const RtLogArg *args, int numArgs)
+{
+    if (level < currentLogLevel.load(std::memory_order_relaxed) || fileLogger == nullptr || site == nullptr) {
+        return;
+    }
+    numArgs = numArgs < kMaxRtLogArgs ? numArgs : kMaxRtLogArgs;
+    uint32_t repeated = 0, limited = 0;
+    if (!admitSite(level, site, hashRtArgs(args, numArgs), repeated, limited)) {
+        return;
+    }
 
-    std::ostringstream threadIdStr;
-    threadIdStr << entry.threadId;
+    RtLogRing *ring = claimRtRing();
+    if (ring == nullptr) {
+        rtRingsExhausted.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
 
-    std::ostringstream logPrefix;
-    logPrefix << timestamp.str() << " [" << processIdString << "." << threadIdStr.str() << "] "
-              << levelToString(entry.level) << " " << entry.file << ":" << entry.line << " @" << entry.function;
+    uint32_t head = ring->head.load(std::memory_order_relaxed);
+    uint32_t tail = ring->tail.load(std::memory_order_acquire);
+    if (head - tail >= kRtRingCapacity) {
+        ring->dropped.fetch_add(1 + repeated + limited, std::memory_order_relaxed);
+        return;
+    }
 
-    std::string logPrefixStr = logPrefix.str();
-    if (logPrefixStr.length() < 96) {
-        logPrefixStr.append(96 - logPrefixStr.length(), ' ');
+    RtLogRecord &record = ring->records[head & (kRtRingCapacity - 1)];
+    record.timestamp = std::chrono::system_clock::now();
+    record.site = site;
+    record.level = level;
+    record.numArgs = numArgs;
+    record.repeated = repeated;
+    record.limited = limited;
+    for (int i = 0; i < record.numArgs; i++) {
+        record.args[i] = args[i];
     }
+    ring->head.store(head + 1, std::memory_order_release);
+}
 
-    std::ostringstream logMessage;
-    logMessage << logPrefixStr << " " << entry.message;
-    return logMessage.str();
+void myLogger::drainRtRings()
+{
+    for (int i = 0; i < kMaxRtRings; i++) {
+        RtLogRing &ring = rtRings[i];
+        if (!ring.claimed.load(std::memory_order_acquire)) {
+            continue;
+        }
+        // read before head, so that everything the owner pushed before it exited is drained below
+        const bool released = ring.released.load(std::memory_order_acquire);
+        uint32_t dropped = ring.dropped.exchange(0, std::memory_order_relaxed);
+        if (dropped > 0) {
+            appendLogLine("realtime logger ring overflow, dropped " + std::to_string(dropped) + " messages");
+        }
+        uint32_t tail = ring.tail.load(std::memory_order_relaxed);
+        uint32_t head = ring.head.load(std::memory_order_acquire);
+        while (tail != head) {
+            const RtLogRecord &record = ring.records[tail & (kRtRingCapacity - 1)];
+            setEntrySite(rtEntry, record.site);
+            rtEntry.timestamp = record.timestamp;
+            rtEntry.threadId = ring.owner;
+            rtEntry.level = record.level;
+            rtEntry.repeated = record.repeated;
+            rtEntry.limited = record.limited;
+            writeHeldBackReport(rtEntry);
+            if (binLog.isOpen()) {
+                binLog.writeRtEvent(record.site, record.site->file, record.site->function, record.site->line,
+                                    record.site->format, ring.owner, record.level, record.timestamp, record.args,
+                                    record.numArgs);
+            } else {
+                expandLogFormat(record.site->format, record.args, record.numArgs, rtEntry.message);
+                appendLogLine(rtEntry);
+            }
+            ring.tail.store(++tail, std::memory_order_release);
+        }
+        if (released) {
+            ring.released.store(false, std::memory_order_relaxed);
+            ring.claimed.store(false, std::memory_order_release);
+        }
+    }
+    uint32_t exhausted = rtRingsExhausted.exchange(0, std::memory_order_relaxed);
+    if (exhausted > 0) {
+        appendLogLine("no free realtime logger ring, dropped " + std::to_string(exhausted) + " messages");
+    }
 }
 
-void myLogger::workerLoop()
+void myLogger::setEntrySite(LogEntry &entry, const LogSite_t *site)
 {
-    for (;;) {
-        std::deque<LogEntry> localQueue;
-        size_t droppedInBatch = 0;
+    // the site holds __FILE__ and __FUNCTION__, only their last component is logged
+    const char *file = site->file != nullptr ? site->file : "unknown_file";
+    const char *fileName = strrchr(file, '\\') ? strrchr(file, '\\') : strrchr(file, '/');
+    entry.file = fileName != nullptr ? fileName + 1 : file;
+    const char *function = site->function != nullptr ? site->function : "unknown_function";
+    const char *functionName = strrchr(function, ':');
+    entry.function = functionName != nullptr ? functionName + 1 : function;
+    entry.line = site->line;
+}
 
-        {
-            std::unique_lock<std::mutex> lock(queueMutex);
-            queueCv.wait(lock, [this] {
-                return !workerRunning.load(std::memory_order_relaxed) || !logQueue.empty();
-            });
+bool myLogger::admitSite(LogLevel_t level, LogSite_t *site, uint64_t hash, uint32_t &repeated, uint32_t &limited)
+{
+    LogSiteState_t &state = site->state;
+    std::atomic<int32_t> &registered = siteAtomic(state.registered);
+    if (registered.load(std::memory_order_relaxed) == 0) {
+        int32_t expected = 0;
+        if (registered.compare_exchange_strong(expected, 1, std::memory_order_relaxed)) {
+            LogSite_t *first = firstSite.load(std::memory_order_relaxed);
+            do {
+                siteAtomic(state.nextSite).store(first, std::memory_order_relaxed);
+            } while (!firstSite.compare_exchange_weak(first, site, std::memory_order_release,
+                                                      std::memory_order_relaxed));
+        }
+    }
+    if (level < LOG_DEBUG || level > LOG_ERROR) {
+        return true;
+    }
 
-            if (!workerRunning.load(std::memory_order_relaxed) && logQueue.empty()) {
+    // Concurrent messages of one site may count a repeat as a new message or the other way round, never more
+    const int index = level - LOG_DEBUG;
+    const int64_t now = steadyMicros();
+    const int64_t lastLogged = siteAtomic(state.lastLogged).load(std::memory_order_relaxed);
+    if (limitCollapseRepeats[index].load(std::memory_order_relaxed) && lastLogged != 0 &&
+        now - lastLogged < std::chrono::duration_cast<std::chrono::microseconds>(kRepeatWindow).count() &&
+        siteAtomic(state.lastHash).load(std::memory_order_relaxed) == hash) {
+        siteAtomic(state.repeated).fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // Token bucket kept as one time (GCRA): nextAllowed is when the messages let through so far would have been
+    // spent at the average rate. A message that would push it more than burst intervals past now is over.
+    const int64_t interval = limitIntervals[index].load(std::memory_order_relaxed);
+    if (interval > 0) {
+        const int64_t tolerance = interval * limitBursts[index].load(std::memory_order_relaxed);
+        std::atomic<int64_t> &nextAllowed = siteAtomic(state.nextAllowed);
+        int64_t next = nextAllowed.load(std::memory_order_relaxed);
+        for (;;) {
+            const int64_t newNext = (next > now ? next : now) + interval;
+            if (newNext - now > tolerance) {
+                siteAtomic(state.limited).fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            if (nextAllowed.compare_exchange_weak(next, newNext, std::memory_order_relaxed)) {
                 break;
             }
+        }
+    }
+
+    siteAtomic(state.lastHash).store(hash, std::memory_order_relaxed);
+    siteAtomic(state.lastLevel).store(level, std::memory_order_relaxed);
+    siteAtomic(state.lastLogged).store(now, std::memory_order_relaxed);
+    repeated = siteAtomic(state.repeated).exchange(0, std::memory_order_relaxed);
+    limited = siteAtomic(state.limited).exchange(0, std::memory_order_relaxed);
+    return true;
+}
+
+void myLogger::writeHeldBackReport(const LogEntry &entry)
+{
+    if (entry.repeated == 0 && entry.limited == 0) {
+        return;
+    }
+    // attributed to the site, just before the message that ends the series
+    reportEntry.timestamp = entry.timestamp;
+    reportEntry.threadId = entry.threadId;
+    reportEntry.level = entry.level;
+    reportEntry.file = entry.file;
+    reportEntry.function = entry.function;
+    reportEntry.line = entry.line;
+    reportEntry.message.clear();
+    if (entry.repeated > 0) {
+        reportEntry.message = "last message repeated " + std::to_string(entry.repeated) + " times";
+    }
+    if (entry.limited > 0) {
+        reportEntry.message += reportEntry.message.empty() ? "" : ", ";
+        reportEntry.message += std::to_string(entry.limited) + " messages over the rate limit dropped";
+    }
+    writeLogEntry(reportEntry);
+}
 
-            localQueue.swap(logQueue);
-            droppedInBatch = droppedLogCount;
-            droppedLogCount = 0;
+void myLogger::reportQuietSites()
+{
+    const auto now = std::chrono::steady_clock::now();
+    if (now - lastQuietSiteScan < kQuietSiteScanInterval) {
+        return;
+    }
+    lastQuietSiteScan = now;
+    const int64_t nowMicros = steadyMicros();
+    const int64_t window = std::chrono::duration_cast<std::chrono::microseconds>(kRepeatWindow).count();
+    LogEntry entry;
+    for (LogSite_t *site = firstSite.load(std::memory_order_acquire); site != nullptr;
+         site = siteAtomic(site->state.nextSite).load(std::memory_order_relaxed)) {
+        LogSiteState_t &state = site->state;
+        if (siteAtomic(state.repeated).load(std::memory_order_relaxed) == 0 &&
+            siteAtomic(state.limited).load(std::memory_order_relaxed) == 0) {
+            continue;
+        }
+        if (nowMicros - siteAtomic(state.lastLogged).load(std::memory_order_relaxed) < window) {
+            continue;
         }
+        // the series ended without another message, report it and start the window again
+        siteAtomic(state.lastLogged).store(nowMicros, std::memory_order_relaxed);
+        setEntrySite(entry, site);
+        entry.timestamp = std::chrono::system_clock::now();
+        entry.threadId = std::this_thread::get_id();
+        entry.level = static_cast<LogLevel_t>(siteAtomic(state.lastLevel).load(std::memory_order_relaxed));
+        entry.repeated = siteAtomic(state.repeated).exchange(0, std::memory_order_relaxed);
+        entry.limited = siteAtomic(state.limited).exchange(0, std::memory_order_relaxed);
+        writeHeldBackReport(entry);
+    }
+}
+
+void myLogger::writeLogEntry(const LogEntry &entry)
+{
+    if (binLog.isOpen()) {
+        binLog.writeTextEvent(entry.file, entry.function, entry.line, entry.threadId, entry.level, entry.timestamp,
+                              entry.message.data(), entry.message.size());
+    } else {
+        appendLogLine(entry);
+    }
+}
+
+void myLogger::appendLogLine(const LogEntry &entry)
+{
+    if (!logBatch.empty()) {
+        logBatch += juce::NewLine::getDefault();
+    }
+    formatter.append(logBatch, entry.timestamp, entry.threadId, myLogFormatter::getLevelName(entry.level),
+                     entry.file, entry.line, entry.function, entry.message.data(), entry.message.size());
+    if (logBatch.size() >= kMaxBatchBytes) {
+        flushLogBatch();
+    }
+}
+
+void myLogger::appendLogLine(const std::string &text)
+{
+    if (binLog.isOpen()) {
+        binLog.writeNote(text);
+        return;
+    }
+    if (!logBatch.empty()) {
+        logBatch += juce::NewLine::getDefault();
+    }
+    logBatch += text;
+    if (logBatch.size() >= kMaxBatchBytes) {
+        flushLogBatch();
+    }
+}
 
+void myLogger::flushLogBatch()
+{
+    if (!logBatch.empty()) {
+        // FileLogger opens the file for every call and ends what it is given with a new line
+        fileLogger->logMessage(logBatch);
+        logBatch.clear();
+    }
+    if (binLog.isOpen() && !binLog.flush()) {
+        fileLogger->logMessage("cannot write the binary log " + getBinaryLogFile().getFullPathName());
+    }
+}
+
+void myLogger::updateBinaryLog()
+{
+    // switched between rounds only, so that a round goes to one of the logs as a whole
+    const bool requested = binaryLogRequested.load(std::memory_order_relaxed);
+    if (requested == binLog.isOpen()) {
+        return;
+    }
+    const juce::String binaryLogPath = getBinaryLogFile().getFullPathName();
+    if (requested) {
+        appendLogLine("binary log on, the following messages go to " + binaryLogPath.toStdString());
+        flushLogBatch();
+        binLog.open(binaryLogPath.toStdString(), processIdString);
+    } else {
+        binLog.close();
+        appendLogLine("binary log off, the previous messages are in " + binaryLogPath.toStdString());
+    }
+}
+
+void myLogger::workerLoop()
+{
+    for (;;) {
+        // read first, so that the last round still sees everything logged before the stop
+        const bool stopping = !workerRunning.load(std::memory_order_acquire);
         if (fileLogger == nullptr) {
+            if (stopping) {
+                break;
+            }
+            std::this_thread::sleep_for(kWorkerPollInterval);
             continue;
         }
 
-        if (droppedInBatch > 0) {
-            std::ostringstream dropMsg;
-            dropMsg << "logger queue overflow, dropped " << droppedInBatch << " messages";
-            fileLogger->logMessage(dropMsg.str());
+        updateBinaryLog();
+        const uint32_t dropped = droppedLogCount.exchange(0, std::memory_order_relaxed);
+        if (dropped > 0) {
+            appendLogLine("logger queue overflow, dropped " + std::to_string(dropped) + " messages");
         }
+        const bool drained = drainQueue();
+        drainRtRings();
+        reportQuietSites();
+        flushLogBatch();
 
-        for (const auto &entry : localQueue) {
-            fileLogger->logMessage(formatLogMessage(entry));
+        if (stopping) {
+            binLog.close();
+            break;
+        }
+        if (!drained) {
+            std::this_thread::sleep_for(kWorkerPollInterval);
         }
     }
 }
 
+void myLogger::setRateLimit(LogLevel_t level, const RateLimit &limit)
+{
+    if (level < LOG_DEBUG || level > LOG_ERROR) {
+        return;
+    }
+    const int index = level - LOG_DEBUG;
+    const int64_t interval =
+        limit.messagesPerSecond > 0.0 ? std::max<int64_t>(1, std::llround(1e6 / limit.messagesPerSecond)) : 0;
+    limitIntervals[index].store(interval, std::memory_order_relaxed);
+    limitBursts[index].store(limit.burst > 0 ? limit.burst : 1, std::memory_order_relaxed);
+    limitCollapseRepeats[index].store(limit.collapseRepeats, std::memory_order_relaxed);
+}
+
+myLogger::RateLimit myLogger::getRateLimit(LogLevel_t level) const
+{
+    RateLimit limit;
+    if (level < LOG_DEBUG || level > LOG_ERROR) {
+        return limit;
+    }
+    const int index = level - LOG_DEBUG;
+    const int64_t interval = limitIntervals[index].load(std::memory_order_relaxed);
+    limit.messagesPerSecond = interval > 0 ? 1e6 / static_cast<double>(interval) : 0.0;
+    limit.burst = limitBursts[index].load(std::memory_order_relaxed);
+    limit.collapseRepeats = limitCollapseRepeats[index].load(std::memory_order_relaxed);
+    return limit;
+}
+
 void myLogger::setLogLevel(LogLevel_t level)
 {
     currentLogLevel.store(level, std::memory_order_relaxed);
+    if (level < LOG_MIN_LEVEL) {
+        LOG_MSG(LOG_WARN, "Log sites below level " + std::to_string(LOG_MIN_LEVEL) + " are not in this build");
+    }
 }
 
-void log_msg(LogLevel_t level, const std::string &message, const char *file, const char *function, int line)
+void log_msg(LogLevel_t level, const std::string &message, const char *file, const char *function, int line,
+             LogSite_t *site)
 {
-    myLogger::getInstance().logMsg(level, message, file, function, line);
+    myLogger::getInstance().logMsg(level, message, file, function, line, site);
 }
 
 extern "C" {
 
-void log_msg_c(LogLevel_t level, const char *message, const char *file, const char *function, int line)
+int log_level_enabled_c(LogLevel_t level)
+{
+    return myLogger::getInstance().isLevelEnabled(level) ? 1 : 0;
+}
+
+void log_msg_c(LogLevel_t level, const char *message, const char *file, const char *function, int line,
+               LogSite_t *site)
 {
-    log_msg(level, message != nullptr ? message : "", file, function, line);
+    log_msg(level, message != nullptr ? message : "", file, function, line, site);
+}
+
+void log_rt_c(LogLevel_t level, LogSite_t *site, const double *args, int num_args)
+{
+    myLogger::RtLogArg packed[myLogger::kMaxRtLogArgs];
+    int count = num_args < myLogger::kMaxRtLogArgs ? num_args : myLogger::kMaxRtLogArgs;
+    for (int i = 0; i < count; i++) {
+        packed[i].type = myLogger::RtLogArg::Double;
+        packed[i].d = args[i];
+    }
+    myLogger::getInstance().pushRtRecord(level, site, packed, count);
 }
 }
@@ -8,6 +8,7 @@
 
 #pragma once
 
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -27,44 +28,193 @@ typedef enum LogLevel {
     LOG_OFF
 } LogLevel_t;
 
+// Call sites below this level are compiled out, arguments included. Release builds drop the DEBUG ones, the
+// log level can still be set lower but has nothing more to show. Define LOG_MIN_LEVEL to choose otherwise.
+#ifndef LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define LOG_MIN_LEVEL 2 // LOG_INFO
+#else
+#define LOG_MIN_LEVEL 1 // LOG_DEBUG
+#endif
+#endif
+
+// Rate limit and repeat bookkeeping of a call site, zero at start. Plain C so that C call sites can hold it,
+// only myLogger touches it, as atomics. Times are microseconds of std::chrono::steady_clock.
+typedef struct LogSiteState {
+    int64_t nextAllowed;       // the rate limit as a virtual scheduling time, see myLogger::admitSite
+    int64_t lastLogged;        // when the last message of the site was let through
+    uint64_t lastHash;         // of that message
+    uint32_t repeated;         // messages identical to it that were collapsed since
+    uint32_t limited;          // messages that were over the rate limit since
+    int32_t lastLevel;
+    int32_t registered;
+    struct LogSite *nextSite;  // sites seen so far, the worker reports their repeats
+} LogSiteState_t;
+
+// Static description of a log call site. The format of a realtime site is only expanded by the worker thread,
+// the other sites have none.
+typedef struct LogSite {
+    const char *file;
+    const char *function;
+    int line;
+    const char *format;
+    LogSiteState_t state;
+} LogSite_t;
+
+// Initialiser of the state of a static site, all zero
+#ifdef __cplusplus
+#define LOG_SITE_STATE_INIT {}
+#else
+#define LOG_SITE_STATE_INIT {0}
+#endif
+
 #ifdef __cplusplus
 #include <JuceHeader.h>
+#include "myBinLog.h"
+#include "myLogFormatter.h"
 #include <JucePluginDefines.h>
 #include <atomic>
 #include <chrono>
-#include <condition_variable>
 #include <cstring>
-#include <deque>
-#include <mutex>
 #include <string>
 #include <thread>
+#include <type_traits>
 
 class myLogger
 {
 public:
+    static constexpr int kMaxRtLogArgs = 6;
+
+    using RtLogArg = myLogArg;
+
     static myLogger &getInstance()
     {
         static myLogger instance;
         return instance;
     }
 
-    void logMsg(LogLevel_t level, const std::string &message, const char *file, const char *function, int line);
+    // Per level limits of every call site: at most messagesPerSecond on average with bursts of burst messages,
+    // and a message identical to the last one of its site within kRepeatWindow is only counted. What was
+    // held back is reported with the next message of the site, or by the worker once the site is quiet.
+    struct RateLimit {
+        double messagesPerSecond = 0.0; // 0 for no limit
+        uint32_t burst = 1;
+        bool collapseRepeats = false;
+    };
+    static constexpr std::chrono::seconds kRepeatWindow{5};
+
+    // site may be null for messages that are never limited
+    void logMsg(LogLevel_t level, const std::string &message, const char *file, const char *function, int line,
+                LogSite_t *site = nullptr);
+
+    // Realtime-safe: never allocates, locks or formats. The record goes into a preallocated
+    // per-thread ring and is formatted later by the worker thread.
+    template <typename... Args>
+    void logRt(LogLevel_t level, LogSite_t *site, Args... args)
+    {
+        static_assert(sizeof...(Args) <= kMaxRtLogArgs, "too many arguments for a realtime log record");
+        if (level < currentLogLevel.load(std::memory_order_relaxed)) {
+            return;
+        }
+        const RtLogArg packed[sizeof...(Args) + 1] = {makeRtLogArg(args)...};
+        pushRtRecord(level, site, packed, static_cast<int>(sizeof...(Args)));
+    }
+    void pushRtRecord(LogLevel_t level, LogSite_t *site, const RtLogArg *args, int numArgs);
     void setLogLevel(LogLevel_t level);
+    void setRateLimit(LogLevel_t level, const RateLimit &limit);
+    RateLimit getRateLimit(LogLevel_t level) const;
     LogLevel_t getLogLevel() const { return currentLogLevel.load(std::memory_order_relaxed); }
+    bool isLevelEnabled(LogLevel_t level) const { return level >= currentLogLevel.load(std::memory_order_relaxed); }
     juce::File getLogFile() const { return logFile; }
+    // In binary mode the worker writes call sites and raw arguments to getBinaryLogFile() instead of
+    // formatting lines, DumpTools binlog2txt turns it into the text log
+    void setBinaryLog(bool enable) { binaryLogRequested.store(enable, std::memory_order_relaxed); }
+    bool isBinaryLog() const { return binaryLogRequested.load(std::memory_order_relaxed); }
+    juce::File getBinaryLogFile() const { return logFile.withFileExtension("binlog"); }
     juce::File getTempDir() const { return tempDir; }
 
 private:
+    // A message on its way to the file, file and function point to the string literals of the call site
     struct LogEntry {
         std::chrono::system_clock::time_point timestamp;
         std::thread::id threadId;
         LogLevel_t level;
-        std::string file;
-        std::string function;
+        const char *file = nullptr;
+        const char *function = nullptr;
         int line = 0;
         std::string message;
+        uint32_t repeated = 0; // held back at the site before this message, see RateLimit
+        uint32_t limited = 0;
+    };
+
+    static constexpr uint32_t kQueueCapacity = 4096; // slots, power of two
+    static constexpr size_t kSlabSlotBytes = 128;    // message bytes that travel with each slot
+    static constexpr uint32_t kMaxMessageSlots = 64; // longer messages are truncated
+
+    // Slot of the bounded multi-producer queue. A message takes as many consecutive slots as its text needs
+    // in the slab, the header lives in the first one. sequence says whose turn the slot is: position when it
+    // is free for the producer of that position, position + 1 when it holds a message for the worker.
+    struct alignas(64) LogSlot {
+        std::atomic<uint64_t> sequence{0};
+        std::chrono::system_clock::time_point timestamp;
+        std::thread::id threadId;
+        LogLevel_t level = LOG_DEBUG;
+        const char *file = nullptr;
+        const char *function = nullptr;
+        int line = 0;
+        uint32_t numSlots = 0;
+        uint32_t length = 0;
+        bool truncated = false;
+        uint32_t repeated = 0;
+        uint32_t limited = 0;
+    };
+
+    struct RtLogRecord {
+        std::chrono::system_clock::time_point timestamp;
+        const LogSite_t *site = nullptr;
+        LogLevel_t level = LOG_DEBUG;
+        int numArgs = 0;
+        uint32_t repeated = 0;
+        uint32_t limited = 0;
+        RtLogArg args[kMaxRtLogArgs];
+    };
+
+    static constexpr uint32_t kRtRingCapacity = 512; // power of two
+    static constexpr int kMaxRtRings = 32;
+
+    // Single producer (the thread that claimed it), single consumer (the worker thread). The owner sets released
+    // when it exits, the worker frees the ring for another thread once it has drained what is left.
+    struct RtLogRing {
+        std::atomic<bool> claimed{false};
+        std::atomic<bool> released{false};
+        std::thread::id owner;
+        std::atomic<uint32_t> head{0};
+        std::atomic<uint32_t> tail{0};
+        std::atomic<uint32_t> dropped{0};
+        RtLogRecord records[kRtRingCapacity];
     };
 
+    template <typename T>
+    static RtLogArg makeRtLogArg(T value)
+    {
+        RtLogArg arg;
+        if constexpr (std::is_pointer_v<T>) {
+            arg.type = RtLogArg::Pointer;
+            arg.p = value;
+        } else if constexpr (std::is_floating_point_v<T>) {
+            arg.type = RtLogArg::Double;
+            arg.d = static_cast<double>(value);
+        } else if constexpr (std::is_signed_v<T> || std::is_enum_v<T>) {
+            arg.type = RtLogArg::Int;
+            arg.i = static_cast<int64_t>(value);
+        } else {
+            static_assert(std::is_integral_v<T>, "realtime log arguments must be numbers or pointers");
+            arg.type = RtLogArg::UInt;
+            arg.u = static_cast<uint64_t>(value);
+        }
+        return arg;
+    }
+
     myLogger();
     ~myLogger();
     myLogger(const myLogger &) = delete;
@@ -72,8 +222,18 @@ private:
 
     void initializeLogger();
     void workerLoop();
-    std::string formatLogMessage(const LogEntry &entry) const;
-    const char *levelToString(LogLevel_t level) const;
+    bool drainQueue();
+    void appendLogLine(const LogEntry &entry);
+    void appendLogLine(const std::string &text);
+    void flushLogBatch();
+    void updateBinaryLog();
+    RtLogRing *claimRtRing();
+    void drainRtRings();
+    bool admitSite(LogLevel_t level, LogSite_t *site, uint64_t hash, uint32_t &repeated, uint32_t &limited);
+    void writeHeldBackReport(const LogEntry &entry);
+    void reportQuietSites();
+    void writeLogEntry(const LogEntry &entry);
+    static void setEntrySite(LogEntry &entry, const LogSite_t *site);
 
     std::unique_ptr<juce::FileLogger> fileLogger;
     juce::File tempDir, logFile;
@@ -81,33 +241,101 @@ private:
 
     std::atomic<bool> workerRunning{false};
     std::thread workerThread;
-    std::mutex queueMutex;
-    std::condition_variable queueCv;
-    std::deque<LogEntry> logQueue;
-    size_t droppedLogCount = 0;
+    std::unique_ptr<LogSlot[]> logSlots;
+    std::unique_ptr<char[]> messageSlab; // kSlabSlotBytes per slot
+    std::atomic<uint64_t> enqueuePosition{0};
+    uint64_t dequeuePosition = 0; // worker thread only
+    std::atomic<uint32_t> droppedLogCount{0};
+    std::unique_ptr<RtLogRing[]> rtRings;
+    std::atomic<uint32_t> rtRingsExhausted{0};
+    std::atomic<bool> binaryLogRequested{false};
     std::string processIdString;
 
-    static constexpr size_t kMaxQueueSize = 4096;
+    // RateLimit per level from LOG_DEBUG to LOG_ERROR, the interval between messages in us, 0 for no limit
+    static constexpr int kNumLimitedLevels = LOG_ERROR;
+    std::atomic<int64_t> limitIntervals[kNumLimitedLevels];
+    std::atomic<uint32_t> limitBursts[kNumLimitedLevels];
+    std::atomic<bool> limitCollapseRepeats[kNumLimitedLevels];
+    std::atomic<LogSite_t *> firstSite{nullptr};
+
+    // worker thread only. The lines of a round are written to the file together, one open and write per batch.
+    static constexpr size_t kMaxBatchBytes = 64 * 1024;
+    myLogFormatter formatter;
+    std::string logBatch;
+    LogEntry rtEntry;
+    LogEntry reportEntry;
+    myBinLogWriter binLog; // open while the worker is in binary mode
+    std::chrono::steady_clock::time_point lastQuietSiteScan;
 };
 
-void log_msg(LogLevel_t level, const std::string &message, const char *file, const char *function, int line);
-#define LOG_MSG(level, message) log_msg(level, message, __FILE_NAME__, __FUNCTION_NAME__, __LINE__)
+void log_msg(LogLevel_t level, const std::string &message, const char *file, const char *function, int line,
+             LogSite_t *site = nullptr);
+
+// The level is checked before the message is built, a filtered site costs one relaxed load
+#define LOG_MSG(level, message)                                                                            \
+    do {                                                                                                   \
+        if ((level) >= LOG_MIN_LEVEL && myLogger::getInstance().isLevelEnabled(level)) {                   \
+            static LogSite_t _log_site = {__FILE__, __FUNCTION__, __LINE__, nullptr, LOG_SITE_STATE_INIT}; \
+            log_msg(level, message, __FILE_NAME__, __FUNCTION_NAME__, __LINE__, &_log_site);               \
+        }                                                                                                  \
+    } while (0)
+
+// Realtime log for the audio thread, printf-style format with numeric or pointer arguments only
+#define LOG_RT(level, format, ...)                                                                           \
+    do {                                                                                                     \
+        if ((level) >= LOG_MIN_LEVEL) {                                                                      \
+            static LogSite_t _log_rt_site = {__FILE__, __FUNCTION__, __LINE__, format, LOG_SITE_STATE_INIT}; \
+            myLogger &_log_rt_logger = myLogger::getInstance();                                              \
+            if (_log_rt_logger.isLevelEnabled(level)) {                                                      \
+                _log_rt_logger.logRt(level, &_log_rt_site, ##__VA_ARGS__);                                   \
+            }                                                                                                \
+        }                                                                                                    \
+    } while (0)
 #endif
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-#define LOG_MSG_C(level, message) log_msg_c(level, message, __FILE_NAME__, __FUNCTION_NAME__, __LINE__)
+// Whether a message of this level would be logged now, for C code and the C macros
+int log_level_enabled_c(LogLevel_t level);
+#define LOG_LEVEL_ENABLED_C(level) ((level) >= LOG_MIN_LEVEL && log_level_enabled_c(level))
+
+#define LOG_MSG_C(level, message)                                                                       \
+    do {                                                                                                \
+        if (LOG_LEVEL_ENABLED_C(level)) {                                                               \
+            static LogSite_t _log_site = {__FILE__, __FUNCTION__, __LINE__, NULL, LOG_SITE_STATE_INIT}; \
+            log_msg_c(level, message, __FILE_NAME__, __FUNCTION_NAME__, __LINE__, &_log_site);          \
+        }                                                                                               \
+    } while (0)
+
+// The buffer is only filled for a message that will be logged, snprintf terminates it
+#define LOG_MSG_CF(level, format, ...)                                                                  \
+    do {                                                                                                \
+        if (LOG_LEVEL_ENABLED_C(level)) {                                                               \
+            static LogSite_t _log_site = {__FILE__, __FUNCTION__, __LINE__, NULL, LOG_SITE_STATE_INIT}; \
+            char _log_temp_buf[2048];                                                                   \
+            snprintf(_log_temp_buf, sizeof(_log_temp_buf), format, ##__VA_ARGS__);                      \
+            log_msg_c(level, _log_temp_buf, __FILE_NAME__, __FUNCTION_NAME__, __LINE__, &_log_site);    \
+        }                                                                                               \
+    } while (0)
+
+// site may be NULL for messages that are never limited
+void log_msg_c(LogLevel_t level, const char *message, const char *file, const char *function, int line,
+               LogSite_t *site);
 
-#define LOG_MSG_CF(level, format, ...)                                         \
-    do {                                                                       \
-        char _log_temp_buf[2048] = {0};                                        \
-        snprintf(_log_temp_buf, sizeof(_log_temp_buf), format, ##__VA_ARGS__); \
-        LOG_MSG_C(level, _log_temp_buf);                                       \
+// Realtime log for C code, the numeric arguments travel as double
+#define LOG_RT_C(level, format, ...)                                                                         \
+    do {                                                                                                     \
+        if (LOG_LEVEL_ENABLED_C(level)) {                                                                    \
+            static LogSite_t _log_rt_site = {__FILE__, __FUNCTION__, __LINE__, format, LOG_SITE_STATE_INIT}; \
+            const double _log_rt_args[] = {0, ##__VA_ARGS__};                                                \
+            log_rt_c(level, &_log_rt_site, _log_rt_args + 1,                                                 \
+                     (int)(sizeof(_log_rt_args) / sizeof(double)) - 1);                                      \
+        }                                                                                                    \
     } while (0)
 
-void log_msg_c(LogLevel_t level, const char *message, const char *file, const char *function, int line);
+void log_rt_c(LogLevel_t level, LogSite_t *site, const double *args, int num_args);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,161 @@
+/***************************************************************************
+ * Description: myPCMWriter
+ * version: 0.1.0
+ * Author: Panda-Young
+ * Date: 2026-10-17 21:18:47
+ * Copyright (c) 2024 by Panda-Young, All Rights Reserved.
+ **************************************************************************/
+
+#include "myPCMWriter.h"
+#include "myLogger.h"
+#include "myUtils.h"
+#include <cerrno>
+#include <cstring>
+
+myPCMWriter::~myPCMWriter()
+{
+    close();
+}
+
+bool myPCMWriter::open(const juce::File &pcmFile, const FlushPolicy &policy)
+{
+    close();
+    file = pcmFile;
+    flushPolicy = policy;
+    failed = false;
+    bytesWritten = 0;
+    capacity = juce::jmax<size_t>(policy.bufferBytes / sizeof(float), 1024);
+    try {
+        storage = std::make_unique<char[]>(capacity * sizeof(float) + kAlignment);
+    } catch (const std::bad_alloc &e) {
+        LOG_MSG(LOG_ERROR, "Failed to allocate PCM write buffer: " + std::string(e.what()));
+        return false;
+    }
+    const uintptr_t address = reinterpret_cast<uintptr_t>(storage.get());
+    buffer = reinterpret_cast<float *>(storage.get() + (kAlignment - address % kAlignment) % kAlignment);
+    fill = 0;
+
+    filePtr = fopen(file.getFullPathName().toUTF8(), "ab");
+    if (filePtr == nullptr) {
+        LOG_MSG(LOG_ERROR, "Failed to open file for writing: \"" + file.getFullPathName().toStdString() +
+                               "\". Reason: " + std::string(strerror(errno)));
+        storage.reset();
+        buffer = nullptr;
+        return false;
+    }
+    // the buffer above replaces the stdio one, a flush is then one write call
+    setvbuf(filePtr, nullptr, _IONBF, 0);
+    return true;
+}
+
+bool myPCMWriter::write(const float *data, size_t numSamples)
+{
+    if (!isOpen()) {
+        return false;
+    }
+    if (numSamples > capacity - fill) {
+        if (!flush()) {
+            return false;
+        }
+        if (numSamples >= capacity) {
+            // too large to be worth copying
+            return writeToFile(data, numSamples * sizeof(float));
+        }
+    }
+    const bool wasEmpty = fill == 0;
+    std::memcpy(buffer + fill, data, numSamples * sizeof(float));
+    fill += numSamples;
+    return applyFlushPolicy(wasEmpty);
+}
+
+bool myPCMWriter::write(const float *const *channels, int numChannels, size_t numFrames)
+{
+    return writeChannels(channels, numChannels, numFrames);
+}
+
+bool myPCMWriter::write(const double *const *channels, int numChannels, size_t numFrames)
+{
+    return writeChannels(channels, numChannels, numFrames);
+}
+
+template <typename SampleType>
+bool myPCMWriter::writeChannels(const SampleType *const *channels, int numChannels, size_t numFrames)
+{
+    if (!isOpen() || numChannels <= 0) {
+        return false;
+    }
+    bool wasEmpty = fill == 0;
+    const size_t frameSamples = static_cast<size_t>(numChannels);
+    size_t done = 0;
+    while (done < numFrames) {
+        size_t space = (capacity - fill) / frameSamples;
+        if (space == 0) {
+            if (!flush()) {
+                return false;
+            }
+            space = capacity / frameSamples;
+            wasEmpty = true;
+        }
+        const size_t count = juce::jmin(space, numFrames - done);
+        interleaveSamples(channels, numChannels, static_cast<int>(done), static_cast<int>(count), buffer + fill);
+        fill += count * frameSamples;
+        done += count;
+    }
+    return applyFlushPolicy(wasEmpty);
+}
+
+bool myPCMWriter::applyFlushPolicy(bool wasEmpty)
+{
+    const auto now = std::chrono::steady_clock::now();
+    if (wasEmpty) {
+        oldestBuffered = now;
+        return true;
+    }
+    if (flushPolicy.maxDelaySeconds > 0 &&
+        std::chrono::duration<double>(now - oldestBuffered).count() >= flushPolicy.maxDelaySeconds) {
+        return flush();
+    }
+    return true;
+}
+
+bool myPCMWriter::flush()
+{
+    if (!isOpen() || fill == 0) {
+        return !failed;
+    }
+    const size_t numBytes = fill * sizeof(float);
+    fill = 0;
+    return writeToFile(buffer, numBytes);
+}
+
+bool myPCMWriter::writeToFile(const void *data, size_t numBytes)
+{
+    if (failed) {
+        return false;
+    }
+    if (fwrite(data, 1, numBytes, filePtr) != numBytes) {
+        LOG_MSG(LOG_ERROR, "Failed to write data to file: \"" + file.getFullPathName().toStdString() +
+                               "\". Reason: " + std::string(strerror(errno)));
+        failed = true;
+        return false;
+    }
+    bytesWritten += numBytes;
+    return true;
+}
+
+bool myPCMWriter::close()
+{
+    if (!isOpen()) {
+        return !failed;
+    }
+    flush();
+    if (fclose(filePtr) != 0 && !failed) {
+        LOG_MSG(LOG_ERROR, "Failed to close file: \"" + file.getFullPathName().toStdString() +
+                               "\". Reason: " + std::string(strerror(errno)));
+        failed = true;
+    }
+    filePtr = nullptr;
+    storage.reset();
+    buffer = nullptr;
+    return !failed;
+}
@@ -0,0 +1,67 @@
+/***************************************************************************
+ * Description: Header of myPCMWriter
+ * version: 0.1.0
+ * Author: Panda-Young
+ * Date: 2026-10-17 21:18:47
+ * Copyright (c) 2024 by Panda-Young, All Rights Reserved.
+ **************************************************************************/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+
+// Appends raw interleaved 32-bit float PCM to a file that stays open between writes.
+// Samples are interleaved (see interleaveSamples) straight into one large aligned buffer, which reaches the
+// file in a single unbuffered write when it is full or when the flush policy says so. Not thread safe, one
+// writer belongs to one thread at a time.
+class myPCMWriter
+{
+public:
+    struct FlushPolicy {
+        size_t bufferBytes = 1 << 20;
+        double maxDelaySeconds = 1.0; // a write flushes once the oldest buffered sample is this old, 0 never
+    };
+
+    myPCMWriter() = default;
+    ~myPCMWriter();
+
+    bool open(const juce::File &file, const FlushPolicy &policy);
+    bool open(const juce::File &file) { return open(file, FlushPolicy()); }
+    // Appends numSamples samples that are already interleaved
+    bool write(const float *data, size_t numSamples);
+    // Interleaves and appends numFrames sample frames of each channel
+    bool write(const float *const *channels, int numChannels, size_t numFrames);
+    bool write(const double *const *channels, int numChannels, size_t numFrames);
+    bool flush();
+    // Flushes and closes, returns false if any write failed
+    bool close();
+
+    bool isOpen() const { return filePtr != nullptr; }
+    bool hasFailed() const { return failed; }
+    const juce::File &getFile() const { return file; }
+    uint64_t getBytesWritten() const { return bytesWritten; }
+
+private:
+    template <typename SampleType>
+    bool writeChannels(const SampleType *const *channels, int numChannels, size_t numFrames);
+    bool writeToFile(const void *data, size_t numBytes);
+    bool applyFlushPolicy(bool wasEmpty);
+
+    juce::File file;
+    FILE *filePtr = nullptr;
+    FlushPolicy flushPolicy;
+    std::unique_ptr<char[]> storage;
+    float *buffer = nullptr; // kAlignment aligned view into storage
+    size_t capacity = 0;     // in samples
+    size_t fill = 0;
+    std::chrono::steady_clock::time_point oldestBuffered;
+    uint64_t bytesWritten = 0;
+    bool failed = false;
+
+    static constexpr size_t kAlignment = 64;
+
+    JUCE_DECLARE_NON_COPYABLE(myPCMWriter)
+};
@@ -8,14 +8,26 @@
 
 #include "myUtils.h"
 #include "myLogger.h"
+#include "myPCMWriter.h"
+#include "myWavFile.h"
 #include <JucePluginDefines.h>                   // Include this for JucePlugin_Name
 #include <cstring>                               // Include this for std::strrchr
-#include <fstream>                               // Include this for std::ofstream, std::ifstream
+#include <deque>                                 // Include this for std::deque
 #include <iomanip>                               // Include this for std::put_time
 #include <juce_cryptography/juce_cryptography.h> // Include this for MD5
+#include <map>                                   // Include this for std::map
+#include <mutex>                                 // Include this for std::mutex, std::lock_guard
 #include <regex>                                 // Include this for std::regex, std::smatch
 #include <sstream>                               // Include this for std::ostringstream, std::istringstream
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define UTILS_INTERLEAVE_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#define UTILS_INTERLEAVE_NEON 1
+#include <arm_neon.h>
+#endif
+
 PluginType_t getPluginType()
 {
     juce::File dllPath = juce::File::getSpecialLocation(juce::File::currentExecutableFile);
@@ -64,65 +76,166 @@ int getAuditionVersion()
     return -1;
 }
 
-void dumpFloatPCMData(const juce::File &pcmFile, const float *data, size_t numSamples)
+void interleaveSamples(const float *const *channels, int numChannels, int startSample, int numSamples, float *dest)
 {
-    std::ofstream outFile(pcmFile.getFullPathName().toStdString(), std::ios::binary | std::ios::app);
-    if (!outFile) {
-        LOG_MSG(LOG_ERROR, "Failed to open file for writing: \"" + pcmFile.getFullPathName().toStdString() +
-                               "\". Reason: " + std::string(strerror(errno)));
+    if (numChannels == 1) {
+        std::memcpy(dest, channels[0] + startSample, static_cast<size_t>(numSamples) * sizeof(float));
+        return;
+    }
+    if (numChannels == 2) {
+        const float *left = channels[0] + startSample;
+        const float *right = channels[1] + startSample;
+        int i = 0;
+#if UTILS_INTERLEAVE_SSE2
+        for (; i + 4 <= numSamples; i += 4) {
+            __m128 l = _mm_loadu_ps(left + i);
+            __m128 r = _mm_loadu_ps(right + i);
+            _mm_storeu_ps(dest + 2 * i, _mm_unpacklo_ps(l, r));
+            _mm_storeu_ps(dest + 2 * i + 4, _mm_unpackhi_ps(l, r));
+        }
+#elif UTILS_INTERLEAVE_NEON
+        for (; i + 4 <= numSamples; i += 4) {
+            float32x4x2_t lr = {{vld1q_f32(left + i), vld1q_f32(right + i)}};
+            vst2q_f32(dest + 2 * i, lr);
+        }
+#endif
+        for (; i < numSamples; i++) {
+            dest[2 * i] = left[i];
+            dest[2 * i + 1] = right[i];
+        }
         return;
     }
-    outFile.write(reinterpret_cast<const char *>(data), numSamples * sizeof(float));
-    outFile.close();
-    if (!outFile) {
-        LOG_MSG(LOG_ERROR, "Failed to write data to file: \"" + pcmFile.getFullPathName().toStdString() +
-                               "\". Reason: " + std::string(strerror(errno)));
+    for (int channel = 0; channel < numChannels; channel++) {
+        const float *source = channels[channel] + startSample;
+        for (int i = 0; i < numSamples; i++) {
+            dest[i * numChannels + channel] = source[i];
+        }
     }
 }
 
-void dumpFloatPCMData(const juce::File &pcmFile, const float *dataLeft, const float *dataRight, size_t numSamples)
+void interleaveSamples(const double *const *channels, int numChannels, int startSample, int numSamples, float *dest)
 {
-    std::ofstream outFile(pcmFile.getFullPathName().toStdString(), std::ios::binary | std::ios::app);
-    if (!outFile) {
-        LOG_MSG(LOG_ERROR, "Failed to open file for writing: \"" + pcmFile.getFullPathName().toStdString() +
-                               "\". Reason: " + std::string(strerror(errno)));
+    if (numChannels == 2) {
+        const double *left = channels[0] + startSample;
+        const double *right = channels[1] + startSample;
+        int i = 0;
+#if UTILS_INTERLEAVE_SSE2
+        for (; i + 4 <= numSamples; i += 4) {
+            __m128 l = _mm_movelh_ps(_mm_cvtpd_ps(_mm_loadu_pd(left + i)), _mm_cvtpd_ps(_mm_loadu_pd(left + i + 2)));
+            __m128 r = _mm_movelh_ps(_mm_cvtpd_ps(_mm_loadu_pd(right + i)), _mm_cvtpd_ps(_mm_loadu_pd(right + i + 2)));
+            _mm_storeu_ps(dest + 2 * i, _mm_unpacklo_ps(l, r));
+            _mm_storeu_ps(dest + 2 * i + 4, _mm_unpackhi_ps(l, r));
+        }
+#elif UTILS_INTERLEAVE_NEON && (defined(__aarch64__) || defined(_M_ARM64))
+        for (; i + 4 <= numSamples; i += 4) {
+            float32x4_t l = vcombine_f32(vcvt_f32_f64(vld1q_f64(left + i)), vcvt_f32_f64(vld1q_f64(left + i + 2)));
+            float32x4_t r = vcombine_f32(vcvt_f32_f64(vld1q_f64(right + i)), vcvt_f32_f64(vld1q_f64(right + i + 2)));
+            float32x4x2_t lr = {{l, r}};
+            vst2q_f32(dest + 2 * i, lr);
+        }
+#endif
+        for (; i < numSamples; i++) {
+            dest[2 * i] = static_cast<float>(left[i]);
+            dest[2 * i + 1] = static_cast<float>(right[i]);
+        }
         return;
     }
-    for (size_t i = 0; i < numSamples; ++i) {
-        outFile.write(reinterpret_cast<const char *>(&dataLeft[i]), sizeof(float));
-        outFile.write(reinterpret_cast<const char *>(&dataRight[i]), sizeof(float));
+    for (int channel = 0; channel < numChannels; channel++) {
+        const double *source = channels[channel] + startSample;
+        for (int i = 0; i < numSamples; i++) {
+            dest[i * numChannels + channel] = static_cast<float>(source[i]);
+        }
     }
-    outFile.close();
-    if (!outFile) {
-        LOG_MSG(LOG_ERROR, "Failed to write data to file: \"" + pcmFile.getFullPathName().toStdString() +
-                               "\". Reason: " + std::string(strerror(errno)));
+}
+
+// Writers the dump helpers keep open, by path, so that calling them once per block costs no open and close.
+// The least recently opened one is closed when there are too many, it appends again when it is reopened.
+struct PCMWriterCache {
+    static constexpr size_t kMaxOpenWriters = 8;
+    std::mutex mutex;
+    std::map<std::string, std::unique_ptr<myPCMWriter>> writers;
+    std::deque<std::string> openOrder;
+
+    // mutex is held
+    myPCMWriter *get(const juce::File &pcmFile)
+    {
+        const std::string path = pcmFile.getFullPathName().toStdString();
+        auto found = writers.find(path);
+        if (found != writers.end()) {
+            return found->second.get();
+        }
+        if (writers.size() >= kMaxOpenWriters) {
+            writers.erase(openOrder.front());
+            openOrder.pop_front();
+        }
+        auto writer = std::make_unique<myPCMWriter>();
+        if (!writer->open(pcmFile)) {
+            return nullptr;
+        }
+        openOrder.push_back(path);
+        return (writers[path] = std::move(writer)).get();
     }
+
+    void close(const juce::File &pcmFile)
+    {
+        const std::string path = pcmFile.getFullPathName().toStdString();
+        if (writers.erase(path) > 0) {
+            openOrder.erase(std::find(openOrder.begin(), openOrder.end(), path));
+        }
+    }
+};
+
+static PCMWriterCache &getPCMWriterCache()
+{
+    // constructed on first use, after the logger, so that it is destroyed and flushed before it
+    static PCMWriterCache cache;
+    return cache;
 }
 
-void dumpFloatBufferData(const juce::File &pcmFile, juce::AudioBuffer<float> &buffer)
+void dumpFloatPCMData(const juce::File &pcmFile, const float *data, size_t numSamples)
 {
-    std::ofstream outFile(pcmFile.getFullPathName().toStdString(), std::ios::binary | std::ios::app);
-    if (!outFile) {
-        LOG_MSG(LOG_ERROR, "Failed to open file for writing: \"" + pcmFile.getFullPathName().toStdString() +
-                               "\". Reason: " + std::string(strerror(errno)));
-        return;
+    PCMWriterCache &cache = getPCMWriterCache();
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    if (myPCMWriter *writer = cache.get(pcmFile)) {
+        writer->write(data, numSamples);
     }
+}
 
-    for (int i = 0; i < buffer.getNumSamples(); ++i) {
-        for (int channel = 0; channel < buffer.getNumChannels(); ++channel) {
-            outFile.write(reinterpret_cast<const char *>(&buffer.getReadPointer(channel)[i]), sizeof(float));
-        }
+void dumpFloatPCMData(const juce::File &pcmFile, const float *dataLeft, const float *dataRight, size_t numSamples)
+{
+    const float *channels[2] = {dataLeft, dataRight};
+    PCMWriterCache &cache = getPCMWriterCache();
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    if (myPCMWriter *writer = cache.get(pcmFile)) {
+        writer->write(channels, 2, numSamples);
+    }
+}
+
+void dumpFloatBufferData(const juce::File &pcmFile, juce::AudioBuffer<float> &buffer)
+{
+    if (buffer.getNumChannels() == 0) {
+        return;
     }
-    outFile.close();
-    if (!outFile) {
-        LOG_MSG(LOG_ERROR, "Failed to write data to file: \"" + pcmFile.getFullPathName().toStdString() +
-                               "\". Reason: " + std::string(strerror(errno)));
+    PCMWriterCache &cache = getPCMWriterCache();
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    if (myPCMWriter *writer = cache.get(pcmFile)) {
+        writer->write(buffer.getArrayOfReadPointers(), buffer.getNumChannels(),
+                      static_cast<size_t>(buffer.getNumSamples()));
     }
 }
 
+void closePCMDumpFile(const juce::File &pcmFile)
+{
+    PCMWriterCache &cache = getPCMWriterCache();
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    cache.close(pcmFile);
+}
+
 void convertPCMtoWAV(const juce::File &pcmFile, uint16_t Num_Channel, uint32_t SampleRate,
                      uint16_t bits_per_sam, uint16_t audioFormat)
 {
+    // what the dump helpers still buffer for the file goes in first
+    closePCMDumpFile(pcmFile);
     if (!pcmFile.existsAsFile()) {
         LOG_MSG(LOG_WARN, "PCM file does not exist: \"" + pcmFile.getFullPathName().toStdString() + "\"");
         return;
@@ -133,60 +246,14 @@ void convertPCMtoWAV(const juce::File &pcmFile, uint16_t Num_Channel, uint32_t S
         }
         return;
     }
-    std::ifstream pcmFileStream(pcmFile.getFullPathName().toStdString(), std::ios::binary | std::ios::in);
-    if (!pcmFileStream) {
-        LOG_MSG(LOG_ERROR, "Failed to open file for reading: \"" + pcmFile.getFullPathName().toStdString() +
-                               "\". Reason: " + std::string(strerror(errno)));
+    std::string newFilePath = pcmFile.withFileExtension(".wav").getFullPathName().toStdString();
+    std::string error;
+    if (!streamPCMtoWAV(pcmFile.getFullPathName().toStdString(), newFilePath, Num_Channel, SampleRate,
+                        bits_per_sam, audioFormat, error)) {
+        LOG_MSG(LOG_ERROR, "Failed to convert PCM to WAV: " + error);
         return;
     }
 
-    std::string newFilePath = pcmFile.getFullPathName().toStdString();
-    newFilePath.replace(newFilePath.find(".pcm"), 4, ".wav");
-    std::ofstream wavFile(newFilePath, std::ios::binary | std::ios::out);
-    if (!wavFile) {
-        LOG_MSG(LOG_ERROR, "Failed to open file for writing: \"" + pcmFile.getFullPathName().toStdString() +
-                               "\".wav. Reason: " + std::string(strerror(errno)));
-        return;
-    }
-
-    // Calculate sizes
-    pcmFileStream.seekg(0, std::ios::end);
-    std::streamsize pcmSize = pcmFileStream.tellg();
-    pcmFileStream.seekg(0, std::ios::beg);
-
-    uint32_t byteRate = SampleRate * Num_Channel * bits_per_sam / 8;
-    uint16_t blockAlign = Num_Channel * bits_per_sam / 8;
-    uint32_t subchunk2Size = static_cast<uint32_t>(pcmSize);
-    uint32_t chunkSize = 36 + subchunk2Size;
-
-    // Write WAV header
-    wavFile.write("RIFF", 4);
-    wavFile.write(reinterpret_cast<const char *>(&chunkSize), 4);
-    wavFile.write("WAVE", 4);
-    wavFile.write("fmt ", 4);
-
-    uint32_t subchunk1Size = 16;
-    wavFile.write(reinterpret_cast<const char *>(&subchunk1Size), 4);
-    wavFile.write(reinterpret_cast<const char *>(&audioFormat), 2);
-    wavFile.write(reinterpret_cast<const char *>(&Num_Channel), 2);
-    wavFile.write(reinterpret_cast<const char *>(&SampleRate), 4);
-    wavFile.write(reinterpret_cast<const char *>(&byteRate), 4);
-    wavFile.write(reinterpret_cast<const char *>(&blockAlign), 2);
-    wavFile.write(reinterpret_cast<const char *>(&bits_per_sam), 2);
-
-    wavFile.write("data", 4);
-    wavFile.write(reinterpret_cast<const char *>(&subchunk2Size), 4);
-
-    // Write PCM data to WAV file
-    std::vector<char> buffer(static_cast<size_t>(pcmSize));
-    if (pcmFileStream.read(buffer.data(), pcmSize)) {
-        wavFile.write(buffer.data(), pcmSize);
-    }
-
-    // Close files
-    pcmFileStream.close();
-    wavFile.close();
-
     // Delete PCM file
     if (!pcmFile.deleteFile()) {
         LOG_MSG(LOG_ERROR, "Failed to delete PCM file: \"" + pcmFile.getFullPathName().toStdString() + "\"");
@@ -31,10 +31,15 @@ std::string getHostAppName();
 std::string getHostAppDir();
 int getAuditionVersion();
 
+// Interleaves numSamples samples of each channel, starting at startSample, into dest (numChannels * numSamples)
+void interleaveSamples(const float *const *channels, int numChannels, int startSample, int numSamples, float *dest);
+void interleaveSamples(const double *const *channels, int numChannels, int startSample, int numSamples, float *dest);
+// The dump helpers keep the file open and buffered (see myPCMWriter) until closePCMDumpFile or convertPCMtoWAV
 void dumpFloatPCMData(const juce::File &pcmFile, const float *data, size_t numSamples);
 void dumpFloatPCMData(const juce::File &pcmFile, const float *dataLeft,
                       const float *dataRight, size_t numSamples);
 void dumpFloatBufferData(const juce::File &pcmFile, juce::AudioBuffer<float> &buffer);
+void closePCMDumpFile(const juce::File &pcmFile);
 void convertPCMtoWAV(const juce::File &pcmFile, uint16_t Num_Channel, uint32_t SampleRate,
                      uint16_t bits_per_sam = 32, uint16_t audioFormat = 3);
 void deleteEmptyFilesAndFolders(const juce::File &directory);
@@ -0,0 +1,209 @@
+/***************************************************************************
+ * Description: myWavFile
+ * version: 0.1.0
+ * Author: Panda-Young
+ * Date: 2026-10-17 15:02:37
+ * Copyright (c) 2024 by Panda-Young, All Rights Reserved.
+ **************************************************************************/
+
+#include "myWavFile.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+
+static constexpr size_t kCopyBufferBytes = 1 << 20;
+
+static void putTag(uint8_t *dest, const char *tag)
+{
+    std::memcpy(dest, tag, 4);
+}
+
+static void putLE(uint8_t *dest, uint64_t value, int numBytes)
+{
+    for (int i = 0; i < numBytes; i++) {
+        dest[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+static uint64_t getLE(const uint8_t *src, int numBytes)
+{
+    uint64_t value = 0;
+    for (int i = 0; i < numBytes; i++) {
+        value |= static_cast<uint64_t>(src[i]) << (8 * i);
+    }
+    return value;
+}
+
+void buildWavHeader(uint8_t (&header)[kWavHeaderBytes], uint16_t numChannels, uint32_t sampleRate,
+                    uint16_t bitsPerSample, uint16_t audioFormat, uint64_t dataBytes)
+{
+    const uint64_t riffBytes = kWavHeaderBytes - 8 + dataBytes;
+    const bool isRF64 = riffBytes > 0xFFFFFFFFull;
+    const uint32_t blockAlign = static_cast<uint32_t>(numChannels) * bitsPerSample / 8;
+
+    std::memset(header, 0, kWavHeaderBytes);
+    putTag(header, isRF64 ? "RF64" : "RIFF");
+    putLE(header + 4, isRF64 ? 0xFFFFFFFFull : riffBytes, 4);
+    putTag(header + 8, "WAVE");
+    putTag(header + 12, isRF64 ? "ds64" : "JUNK");
+    putLE(header + 16, 28, 4);
+    if (isRF64) {
+        putLE(header + 20, riffBytes, 8);
+        putLE(header + 28, dataBytes, 8);
+        putLE(header + 36, blockAlign ? dataBytes / blockAlign : 0, 8);
+    }
+    putTag(header + 48, "fmt ");
+    putLE(header + 52, 16, 4);
+    putLE(header + 56, audioFormat, 2);
+    putLE(header + 58, numChannels, 2);
+    putLE(header + 60, sampleRate, 4);
+    putLE(header + 64, static_cast<uint64_t>(sampleRate) * blockAlign, 4);
+    putLE(header + 68, blockAlign, 2);
+    putLE(header + 70, bitsPerSample, 2);
+    putTag(header + 72, "data");
+    putLE(header + 76, isRF64 ? 0xFFFFFFFFull : dataBytes, 4);
+}
+
+bool streamPCMtoWAV(const std::string &pcmPath, const std::string &wavPath, uint16_t numChannels,
+                    uint32_t sampleRate, uint16_t bitsPerSample, uint16_t audioFormat, std::string &error)
+{
+    const uint32_t blockAlign = static_cast<uint32_t>(numChannels) * bitsPerSample / 8;
+    if (blockAlign == 0 || sampleRate == 0) {
+        error = "invalid format: " + std::to_string(numChannels) + " channels, " + std::to_string(sampleRate) +
+                " Hz, " + std::to_string(bitsPerSample) + " bits";
+        return false;
+    }
+
+    std::error_code ec;
+    uint64_t pcmBytes = std::filesystem::file_size(pcmPath, ec);
+    if (ec) {
+        error = "cannot stat \"" + pcmPath + "\": " + ec.message();
+        return false;
+    }
+    // a trailing partial sample frame cannot be described by the header, drop it
+    const uint64_t dataBytes = pcmBytes - pcmBytes % blockAlign;
+
+    std::unique_ptr<FILE, int (*)(FILE *)> input(fopen(pcmPath.c_str(), "rb"), &fclose);
+    if (!input) {
+        error = "cannot open \"" + pcmPath + "\": " + std::string(strerror(errno));
+        return false;
+    }
+    std::unique_ptr<FILE, int (*)(FILE *)> output(fopen(wavPath.c_str(), "wb"), &fclose);
+    if (!output) {
+        error = "cannot create \"" + wavPath + "\": " + std::string(strerror(errno));
+        return false;
+    }
+
+    uint8_t header[kWavHeaderBytes];
+    buildWavHeader(header, numChannels, sampleRate, bitsPerSample, audioFormat, dataBytes);
+    if (fwrite(header, 1, kWavHeaderBytes, output.get()) != kWavHeaderBytes) {
+        error = "cannot write \"" + wavPath + "\": " + std::string(strerror(errno));
+        return false;
+    }
+
+    auto buffer = std::make_unique<char[]>(kCopyBufferBytes);
+    uint64_t remaining = dataBytes;
+    while (remaining > 0) {
+        size_t wanted = static_cast<size_t>(remaining < kCopyBufferBytes ? remaining : kCopyBufferBytes);
+        size_t got = fread(buffer.get(), 1, wanted, input.get());
+        if (got != wanted) {
+            error = "short read from \"" + pcmPath + "\"";
+            return false;
+        }
+        if (fwrite(buffer.get(), 1, got, output.get()) != got) {
+            error = "cannot write \"" + wavPath + "\": " + std::string(strerror(errno));
+            return false;
+        }
+        remaining -= got;
+    }
+    if (fclose(output.release()) != 0) {
+        error = "cannot close \"" + wavPath + "\": " + std::string(strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+bool readWavInfo(const std::string &wavPath, WavInfo &info, std::string &error)
+{
+    std::error_code ec;
+    const uint64_t fileBytes = std::filesystem::file_size(wavPath, ec);
+    if (ec) {
+        error = "cannot stat \"" + wavPath + "\": " + ec.message();
+        return false;
+    }
+    std::unique_ptr<FILE, int (*)(FILE *)> input(fopen(wavPath.c_str(), "rb"), &fclose);
+    if (!input) {
+        error = "cannot open \"" + wavPath + "\": " + std::string(strerror(errno));
+        return false;
+    }
+    uint8_t riff[12];
+    if (fread(riff, 1, sizeof(riff), input.get()) != sizeof(riff) ||
+        (std::memcmp(riff, "RIFF", 4) != 0 && std::memcmp(riff, "RF64", 4) != 0) ||
+        std::memcmp(riff + 8, "WAVE", 4) != 0) {
+        error = "\"" + wavPath + "\" is not a WAV file";
+        return false;
+    }
+
+    info = WavInfo();
+    uint64_t ds64DataBytes = 0;
+    uint64_t offset = sizeof(riff);
+    bool haveFormat = false;
+    for (;;) {
+        uint8_t chunk[8];
+        if (fread(chunk, 1, sizeof(chunk), input.get()) != sizeof(chunk)) {
+            error = "\"" + wavPath + "\" has no data chunk";
+            return false;
+        }
+        offset += sizeof(chunk);
+        const uint64_t chunkBytes = getLE(chunk + 4, 4);
+        if (std::memcmp(chunk, "data", 4) == 0) {
+            if (!haveFormat) {
+                error = "\"" + wavPath + "\" has no fmt chunk before its data";
+                return false;
+            }
+            info.dataOffset = offset;
+            info.dataBytes = chunkBytes == 0xFFFFFFFFull ? ds64DataBytes : chunkBytes;
+            const uint64_t available = fileBytes - offset;
+            if (info.dataBytes == 0 || info.dataBytes > available) {
+                info.dataBytes = available;
+            }
+            const uint32_t blockAlign = static_cast<uint32_t>(info.numChannels) * info.bitsPerSample / 8;
+            info.dataBytes -= info.dataBytes % blockAlign;
+            return true;
+        }
+
+        uint8_t body[40] = {0};
+        const size_t wanted = static_cast<size_t>(chunkBytes < sizeof(body) ? chunkBytes : sizeof(body));
+        if (fread(body, 1, wanted, input.get()) != wanted) {
+            error = "\"" + wavPath + "\" is truncated";
+            return false;
+        }
+        if (std::memcmp(chunk, "ds64", 4) == 0 && wanted >= 16) {
+            ds64DataBytes = getLE(body + 8, 8);
+        } else if (std::memcmp(chunk, "fmt ", 4) == 0 && wanted >= 16) {
+            info.audioFormat = static_cast<uint16_t>(getLE(body, 2));
+            info.numChannels = static_cast<uint16_t>(getLE(body + 2, 2));
+            info.sampleRate = static_cast<uint32_t>(getLE(body + 4, 4));
+            info.bitsPerSample = static_cast<uint16_t>(getLE(body + 14, 2));
+            if (info.audioFormat == 0xFFFE && wanted >= 26) {
+                // WAVE_FORMAT_EXTENSIBLE, the sub-format GUID starts with the format tag
+                info.audioFormat = static_cast<uint16_t>(getLE(body + 24, 2));
+            }
+            if (info.numChannels == 0 || info.bitsPerSample == 0 || info.bitsPerSample % 8 != 0 ||
+                (info.audioFormat != kWavFormatPCM && info.audioFormat != kWavFormatIEEEFloat)) {
+                error = "\"" + wavPath + "\" is neither PCM nor IEEE float";
+                return false;
+            }
+            haveFormat = true;
+        }
+        // chunks are padded to an even size
+        const uint64_t skip = chunkBytes + (chunkBytes & 1) - wanted;
+        if (skip > 0 && fseek(input.get(), static_cast<long>(skip), SEEK_CUR) != 0) {
+            error = "\"" + wavPath + "\" is truncated";
+            return false;
+        }
+        offset += chunkBytes + (chunkBytes & 1);
+    }
+}
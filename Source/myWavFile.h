@@ -0,0 +1,44 @@
+/***************************************************************************
+ * Description: Header of myWavFile
+ * version: 0.1.0
+ * Author: Panda-Young
+ * Date: 2026-10-17 15:02:37
+ * Copyright (c) 2024 by Panda-Young, All Rights Reserved.
+ **************************************************************************/
+
+#pragma once
+
+// Plain C++ on purpose, no JUCE, so that the command line tools can share it with the plugin
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// RIFF + JUNK/ds64 + fmt + data chunk headers, the samples start right after
+constexpr size_t kWavHeaderBytes = 80;
+constexpr uint16_t kWavFormatPCM = 1;
+constexpr uint16_t kWavFormatIEEEFloat = 3;
+
+// Fills header with a WAV header for dataBytes of audio. The 28-byte JUNK chunk that keeps room for a ds64
+// chunk becomes one, and RIFF becomes RF64, once the sizes no longer fit into 32 bits, so the same header
+// can be rewritten in place while the file grows.
+void buildWavHeader(uint8_t (&header)[kWavHeaderBytes], uint16_t numChannels, uint32_t sampleRate,
+                    uint16_t bitsPerSample, uint16_t audioFormat, uint64_t dataBytes);
+
+// Copies raw interleaved PCM into a WAV/RF64 file through a fixed-size buffer, so memory use does not
+// depend on the file size. Returns false and fills error on failure.
+bool streamPCMtoWAV(const std::string &pcmPath, const std::string &wavPath, uint16_t numChannels,
+                    uint32_t sampleRate, uint16_t bitsPerSample, uint16_t audioFormat, std::string &error);
+
+// Format and sample data location of a WAV/RF64 file
+struct WavInfo {
+    uint16_t numChannels = 0;
+    uint32_t sampleRate = 0;
+    uint16_t bitsPerSample = 0;
+    uint16_t audioFormat = 0; // kWavFormatPCM or kWavFormatIEEEFloat, also for WAVE_FORMAT_EXTENSIBLE files
+    uint64_t dataOffset = 0;
+    uint64_t dataBytes = 0;
+};
+
+// Parses the chunks in front of the samples. A data size that is zero or runs past the end of the file, as left
+// behind by an interrupted capture, is cut down to the whole sample frames the file holds.
+bool readWavInfo(const std::string &wavPath, WavInfo &info, std::string &error);
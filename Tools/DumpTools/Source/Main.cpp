@@ -0,0 +1,924 @@
+/***************************************************************************
+ * Description: Command line tools for the data dumps of the Demo plugin
+ * version: 0.1.0
+ * Author: Panda-Young
+ * Date: 2026-10-17 15:20:11
+ * Copyright (c) 2024 by Panda-Young, All Rights Reserved.
+ **************************************************************************/
+
+#include "../../../Source/myBinLog.h"
+#include "../../../Source/myDumpCodec.h"
+#include "../../../Source/myDumpMeta.h"
+#include "../../../Source/myLogFormatter.h"
+#include "../../../Source/myWavFile.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+extern "C" {
+#include "../../../Source/lib/algo_example.h"
+}
+
+static void printUsage(const char *program)
+{
+    fprintf(stderr,
+            "Usage:\n"
+            "  %s pcm2wav --channels N --rate HZ [--bits 32] [--format float|pcm] [--delete] file.pcm...\n"
+            "      Converts raw interleaved PCM dumps into WAV (RF64 past 4 GB) next to the input files.\n"
+            "  %s pdz2wav file.pdz...\n"
+            "      Decodes lossless compressed dumps into 32-bit float WAV next to the input files.\n"
+            "  %s replay [--input pre_algo.wav|.pdz] [--reference processed.wav|.pdz] [--output out.wav]\n"
+            "         [--repeat N] session.pdmeta\n"
+            "      Feeds the pre-algorithm dump of a session through algo_process again, with the frame\n"
+            "      boundaries and gain changes of the sidecar, as fast as possible. Checks the result bit for bit\n"
+            "      against the post-algorithm dump and reports the processing speed. The dumps next to the\n"
+            "      sidecar are used unless given.\n"
+            "  %s bench-log [--lines N] [--file path]\n"
+            "      Measures how many log lines per second the plugin logger formats and writes, with the\n"
+            "      formatter of earlier versions and with the current one.\n"
+            "  %s binlog2txt [--output out.txt|-] file.binlog...\n"
+            "      Turns binary logs of the plugin into the lines of its text log, written next to each input\n"
+            "      with .txt appended, or all into one output (- for stdout).\n",
+            program, program, program, program, program);
+}
+
+static int runPcm2Wav(int argc, char **argv)
+{
+    uint16_t numChannels = 0;
+    uint32_t sampleRate = 0;
+    uint16_t bitsPerSample = 32;
+    uint16_t audioFormat = kWavFormatIEEEFloat;
+    bool deleteInput = false;
+    std::vector<std::string> inputs;
+
+    for (int i = 0; i < argc; i++) {
+        const char *arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (strcmp(arg, "--channels") == 0 && hasValue) {
+            numChannels = static_cast<uint16_t>(atoi(argv[++i]));
+        } else if (strcmp(arg, "--rate") == 0 && hasValue) {
+            sampleRate = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(arg, "--bits") == 0 && hasValue) {
+            bitsPerSample = static_cast<uint16_t>(atoi(argv[++i]));
+        } else if (strcmp(arg, "--format") == 0 && hasValue) {
+            audioFormat = strcmp(argv[++i], "pcm") == 0 ? kWavFormatPCM : kWavFormatIEEEFloat;
+        } else if (strcmp(arg, "--delete") == 0) {
+            deleteInput = true;
+        } else if (arg[0] == '-') {
+            fprintf(stderr, "pcm2wav: unknown option %s\n", arg);
+            return 2;
+        } else {
+            inputs.emplace_back(arg);
+        }
+    }
+    if (numChannels == 0 || sampleRate == 0 || inputs.empty()) {
+        fprintf(stderr, "pcm2wav: --channels, --rate and at least one input file are required\n");
+        return 2;
+    }
+
+    int failures = 0;
+    for (const auto &input : inputs) {
+        std::string output = std::filesystem::path(input).replace_extension(".wav").string();
+        std::string error;
+        if (!streamPCMtoWAV(input, output, numChannels, sampleRate, bitsPerSample, audioFormat, error)) {
+            fprintf(stderr, "pcm2wav: %s\n", error.c_str());
+            failures++;
+            continue;
+        }
+        printf("%s -> %s\n", input.c_str(), output.c_str());
+        if (deleteInput) {
+            std::error_code ec;
+            std::filesystem::remove(input, ec);
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+// Reads a .pdz file block by block
+class PdzReader
+{
+public:
+    bool open(const std::string &path)
+    {
+        input.reset(fopen(path.c_str(), "rb"));
+        if (!input) {
+            fprintf(stderr, "cannot open \"%s\": %s\n", path.c_str(), strerror(errno));
+            return false;
+        }
+        uint8_t fileHeader[kDumpCodecFileHeaderBytes];
+        uint32_t blockFrames = 0;
+        if (fread(fileHeader, 1, sizeof(fileHeader), input.get()) != sizeof(fileHeader) ||
+            !decodeDumpFileHeader(fileHeader, numChannels, sampleRate, blockFrames)) {
+            fprintf(stderr, "\"%s\" is not a compressed dump\n", path.c_str());
+            return false;
+        }
+        maxPayload = dumpCodecMaxBytes(numChannels, kDumpCodecBlockFrames);
+        payload = std::make_unique<uint8_t[]>(maxPayload);
+        encodedBytes = kDumpCodecFileHeaderBytes;
+        return true;
+    }
+
+    // Decodes the next block into samples (kDumpCodecBlockFrames frames at most) and returns its frame count,
+    // 0 at the end of the file or -1 if the rest of the file is truncated or corrupt
+    int readBlock(float *samples)
+    {
+        uint8_t blockHeader[kDumpCodecBlockHeaderBytes];
+        size_t got = fread(blockHeader, 1, sizeof(blockHeader), input.get());
+        if (got == 0) {
+            return 0;
+        }
+        int numFrames = 0;
+        size_t payloadBytes = 0;
+        if (got != sizeof(blockHeader) ||
+            !decodeDumpBlockHeader(blockHeader, kDumpCodecBlockFrames, numFrames, payloadBytes) ||
+            payloadBytes > maxPayload || fread(payload.get(), 1, payloadBytes, input.get()) != payloadBytes) {
+            return -1;
+        }
+        auto decodeStart = std::chrono::steady_clock::now();
+        bool decoded = decodeDumpBlockPayload(payload.get(), payloadBytes, numChannels, numFrames, samples);
+        decodeSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - decodeStart).count();
+        if (!decoded) {
+            return -1;
+        }
+        encodedBytes += sizeof(blockHeader) + payloadBytes;
+        return numFrames;
+    }
+
+    uint16_t numChannels = 0;
+    uint32_t sampleRate = 0;
+    uint64_t encodedBytes = 0;
+    double decodeSeconds = 0;
+
+private:
+    std::unique_ptr<FILE, int (*)(FILE *)> input{nullptr, &fclose};
+    std::unique_ptr<uint8_t[]> payload;
+    size_t maxPayload = 0;
+};
+
+static bool decodePdzFile(const std::string &input, const std::string &output)
+{
+    PdzReader reader;
+    if (!reader.open(input)) {
+        return false;
+    }
+    const uint16_t numChannels = reader.numChannels;
+    std::unique_ptr<FILE, int (*)(FILE *)> out(fopen(output.c_str(), "wb"), &fclose);
+    if (!out) {
+        fprintf(stderr, "pdz2wav: cannot create \"%s\": %s\n", output.c_str(), strerror(errno));
+        return false;
+    }
+
+    uint8_t wavHeader[kWavHeaderBytes];
+    buildWavHeader(wavHeader, numChannels, reader.sampleRate, 32, kWavFormatIEEEFloat, 0);
+    fwrite(wavHeader, 1, kWavHeaderBytes, out.get());
+
+    auto samples = std::make_unique<float[]>(static_cast<size_t>(kDumpCodecBlockFrames) * numChannels);
+    uint64_t dataBytes = 0;
+    int numFrames;
+    while ((numFrames = reader.readBlock(samples.get())) > 0) {
+        size_t blockBytes = static_cast<size_t>(numFrames) * numChannels * sizeof(float);
+        if (fwrite(samples.get(), 1, blockBytes, out.get()) != blockBytes) {
+            fprintf(stderr, "pdz2wav: cannot write \"%s\": %s\n", output.c_str(), strerror(errno));
+            return false;
+        }
+        dataBytes += blockBytes;
+    }
+    const bool complete = numFrames == 0;
+    if (!complete) {
+        fprintf(stderr, "pdz2wav: \"%s\" is truncated or corrupt, kept the %llu bytes before the damage\n",
+                input.c_str(), static_cast<unsigned long long>(dataBytes));
+    }
+
+    buildWavHeader(wavHeader, numChannels, reader.sampleRate, 32, kWavFormatIEEEFloat, dataBytes);
+    if (fseek(out.get(), 0, SEEK_SET) != 0 || fwrite(wavHeader, 1, kWavHeaderBytes, out.get()) != kWavHeaderBytes ||
+        fclose(out.release()) != 0) {
+        fprintf(stderr, "pdz2wav: cannot finish \"%s\": %s\n", output.c_str(), strerror(errno));
+        return false;
+    }
+    const uint64_t encodedBytes = reader.encodedBytes;
+    printf("%s -> %s: %llu -> %llu bytes, ratio %.3f, decoder throughput %.1f MB/s\n", input.c_str(),
+           output.c_str(), static_cast<unsigned long long>(encodedBytes), static_cast<unsigned long long>(dataBytes),
+           encodedBytes ? static_cast<double>(dataBytes) / static_cast<double>(encodedBytes) : 0.0,
+           reader.decodeSeconds > 0 ? static_cast<double>(dataBytes) / reader.decodeSeconds / 1e6 : 0.0);
+    return complete;
+}
+
+static int runPdz2Wav(int argc, char **argv)
+{
+    if (argc == 0) {
+        fprintf(stderr, "pdz2wav: at least one input file is required\n");
+        return 2;
+    }
+    int failures = 0;
+    for (int i = 0; i < argc; i++) {
+        std::string output = std::filesystem::path(argv[i]).replace_extension(".wav").string();
+        if (!decodePdzFile(argv[i], output)) {
+            failures++;
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+// Interleaved 32-bit float samples of a .wav or .pdz dump
+struct DumpAudio {
+    uint16_t numChannels = 0;
+    uint32_t sampleRate = 0;
+    std::vector<float> samples;
+
+    size_t getNumFrames() const { return numChannels ? samples.size() / numChannels : 0; }
+};
+
+static bool loadDumpAudio(const std::string &path, DumpAudio &audio)
+{
+    if (std::filesystem::path(path).extension() == ".pdz") {
+        PdzReader reader;
+        if (!reader.open(path)) {
+            return false;
+        }
+        audio.numChannels = reader.numChannels;
+        audio.sampleRate = reader.sampleRate;
+        std::vector<float> block(static_cast<size_t>(kDumpCodecBlockFrames) * reader.numChannels);
+        int numFrames;
+        while ((numFrames = reader.readBlock(block.data())) > 0) {
+            audio.samples.insert(audio.samples.end(), block.begin(),
+                                 block.begin() + static_cast<size_t>(numFrames) * reader.numChannels);
+        }
+        if (numFrames < 0) {
+            fprintf(stderr, "replay: \"%s\" is truncated or corrupt, using the part before the damage\n",
+                    path.c_str());
+        }
+        return true;
+    }
+
+    WavInfo info;
+    std::string error;
+    if (!readWavInfo(path, info, error)) {
+        fprintf(stderr, "replay: %s\n", error.c_str());
+        return false;
+    }
+    if (info.audioFormat != kWavFormatIEEEFloat || info.bitsPerSample != 32) {
+        fprintf(stderr, "replay: \"%s\" is not a 32-bit float dump\n", path.c_str());
+        return false;
+    }
+    std::unique_ptr<FILE, int (*)(FILE *)> input(fopen(path.c_str(), "rb"), &fclose);
+    audio.numChannels = info.numChannels;
+    audio.sampleRate = info.sampleRate;
+    audio.samples.resize(static_cast<size_t>(info.dataBytes / sizeof(float)));
+    if (!input || fseek(input.get(), static_cast<long>(info.dataOffset), SEEK_SET) != 0 ||
+        fread(audio.samples.data(), sizeof(float), audio.samples.size(), input.get()) != audio.samples.size()) {
+        fprintf(stderr, "replay: cannot read \"%s\"\n", path.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Sidecar of a dump session, see myDumpMeta
+struct DumpSession {
+    uint16_t numChannels = 0;
+    uint32_t sampleRate = 0;
+    char algoVersion[kDumpMetaVersionBytes + 1] = {0};
+    DumpMetaGainRamp gainRamp; // in front of the first record
+    std::vector<DumpFrameRecord> records;
+};
+
+static bool loadDumpSession(const std::string &path, DumpSession &session)
+{
+    std::error_code ec;
+    const uint64_t fileBytes = std::filesystem::file_size(path, ec);
+    std::unique_ptr<FILE, int (*)(FILE *)> input(fopen(path.c_str(), "rb"), &fclose);
+    if (ec || !input) {
+        fprintf(stderr, "replay: cannot open \"%s\"\n", path.c_str());
+        return false;
+    }
+    std::vector<uint8_t> bytes(static_cast<size_t>(fileBytes));
+    uint8_t header[kDumpMetaFileHeaderBytes];
+    if (fileBytes < sizeof(header) || fread(bytes.data(), 1, bytes.size(), input.get()) != bytes.size()) {
+        fprintf(stderr, "replay: cannot read \"%s\"\n", path.c_str());
+        return false;
+    }
+    std::memcpy(header, bytes.data(), sizeof(header));
+    if (!decodeDumpMetaFileHeader(header, session.numChannels, session.sampleRate, session.algoVersion,
+                                  session.gainRamp)) {
+        fprintf(stderr, "replay: \"%s\" is not a dump sidecar\n", path.c_str());
+        return false;
+    }
+    size_t position = sizeof(header);
+    while (position < bytes.size()) {
+        DumpFrameRecord record;
+        size_t size = decodeDumpFrameRecord(bytes.data() + position, bytes.size() - position, record);
+        if (size == 0) {
+            fprintf(stderr, "replay: \"%s\" is truncated or corrupt after %zu frames\n", path.c_str(),
+                    session.records.size());
+            break;
+        }
+        session.records.push_back(record);
+        position += size;
+    }
+    return true;
+}
+
+static int algoProcessMulti(void *handle, float *const *buffers, int numChannels, int numSamples)
+{
+    return algo_process_multi(handle, buffers, buffers, numChannels, numSamples);
+}
+
+static int algoProcessMulti(void *handle, double *const *buffers, int numChannels, int numSamples)
+{
+    return algo_process_multi_double(handle, buffers, buffers, numChannels, numSamples);
+}
+
+struct ReplayStats {
+    uint64_t processedFrames = 0;
+    uint64_t processedSamples = 0;
+    uint64_t bypassedFrames = 0;
+    uint64_t missingFrames = 0; // processed in the session but not in the pre-algorithm dump
+    uint64_t resultMismatches = 0;
+    double algoSeconds = 0;
+    double maxFrameMs = 0;
+};
+
+// Replays the session the way DemoAudioProcessor::runFrame and processFrame ran it, output gets the processed
+// frames in the layout of the pre-algorithm dump
+template <typename SampleType>
+static bool replaySession(const DumpSession &session, const DumpAudio &input, std::vector<float> &output,
+                          ReplayStats &stats)
+{
+    const int numChannels = session.numChannels;
+    const size_t numFrames = input.getNumFrames();
+    std::vector<std::vector<SampleType>> planar(numChannels, std::vector<SampleType>(numFrames));
+    for (size_t frame = 0; frame < numFrames; frame++) {
+        for (int channel = 0; channel < numChannels; channel++) {
+            planar[channel][frame] = static_cast<SampleType>(input.samples[frame * numChannels + channel]);
+        }
+    }
+
+    void *handle = algo_init();
+    if (handle == nullptr) {
+        fprintf(stderr, "replay: algo_init failed\n");
+        return false;
+    }
+    float appliedGain = 0.0f;
+    auto applyGain = [&](float gain) {
+        if (gain != appliedGain && algo_set_param(handle, ALGO_PARAM2, &gain, (int)sizeof(float)) == E_OK) {
+            appliedGain = gain;
+        }
+    };
+    if (!session.records.empty()) {
+        // The capture may have started in the middle of a gain ramp, so set the gain of the first frame and
+        // then put the ramp back where the session had it
+        applyGain(session.records.front().gainAtStart);
+        algo_gain_ramp_t ramp;
+        ramp.current = session.gainRamp.current;
+        ramp.target = session.gainRamp.target;
+        ramp.step = session.gainRamp.step;
+        ramp.remaining = static_cast<int>(session.gainRamp.remaining);
+        if (algo_set_param(handle, ALGO_PARAM_GAIN_RAMP, &ramp, (int)sizeof(ramp)) != E_OK) {
+            fprintf(stderr, "replay: cannot restore the gain ramp of the session\n");
+            algo_deinit(handle);
+            return false;
+        }
+    }
+
+    stats = ReplayStats();
+    std::vector<SampleType *> subBlock(numChannels);
+    size_t position = 0;
+    for (const DumpFrameRecord &record : session.records) {
+        if (record.flags & kDumpMetaBypass) {
+            if (record.numGainEvents > 0) {
+                applyGain(record.gainEvents[record.numGainEvents - 1].gain);
+            }
+            stats.bypassedFrames++;
+            continue;
+        }
+        if (!(record.flags & kDumpMetaPreAlgoCaptured) || position + record.frameSize > numFrames) {
+            // the gain still follows the session, but the ramp state does not any more
+            for (uint32_t event = 0; event < record.numGainEvents; event++) {
+                applyGain(record.gainEvents[event].gain);
+            }
+            stats.missingFrames++;
+            continue;
+        }
+
+        auto frameStart = std::chrono::steady_clock::now();
+        uint32_t start = 0;
+        int ret = E_OK;
+        for (uint32_t event = 0; event <= record.numGainEvents; event++) {
+            uint32_t stop = event < record.numGainEvents ? record.gainEvents[event].offset : record.frameSize;
+            if (stop > start) {
+                for (int channel = 0; channel < numChannels; channel++) {
+                    subBlock[channel] = planar[channel].data() + position + start;
+                }
+                int subRet = algoProcessMulti(handle, subBlock.data(), numChannels, static_cast<int>(stop - start));
+                if (subRet != E_OK) {
+                    ret = subRet;
+                }
+                start = stop;
+            }
+            if (event < record.numGainEvents) {
+                applyGain(record.gainEvents[event].gain);
+            }
+        }
+        const double frameSeconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - frameStart).count();
+        stats.algoSeconds += frameSeconds;
+        stats.maxFrameMs = std::max(stats.maxFrameMs, frameSeconds * 1000.0);
+        if (ret != record.result) {
+            stats.resultMismatches++;
+        }
+        stats.processedFrames++;
+        stats.processedSamples += record.frameSize;
+        position += record.frameSize;
+    }
+    algo_deinit(handle);
+
+    output.resize(position * numChannels);
+    for (size_t frame = 0; frame < position; frame++) {
+        for (int channel = 0; channel < numChannels; channel++) {
+            output[frame * numChannels + channel] = static_cast<float>(planar[channel][frame]);
+        }
+    }
+    return true;
+}
+
+// Compares the replayed frames with the post-algorithm dump bit for bit, returns the number of frames that differ
+static uint64_t compareWithReference(const DumpSession &session, const std::vector<float> &output,
+                                     const DumpAudio &reference, uint64_t &comparedFrames)
+{
+    const size_t numChannels = session.numChannels;
+    size_t outputPosition = 0;
+    size_t referencePosition = 0;
+    uint64_t differingFrames = 0;
+    float maxDifference = 0.0f;
+    comparedFrames = 0;
+    for (const DumpFrameRecord &record : session.records) {
+        if (record.flags & kDumpMetaBypass) {
+            continue;
+        }
+        const size_t numSamples = static_cast<size_t>(record.frameSize) * numChannels;
+        const bool replayed = (record.flags & kDumpMetaPreAlgoCaptured) && outputPosition + numSamples <= output.size();
+        const bool captured = (record.flags & kDumpMetaPostAlgoCaptured) &&
+                              referencePosition + numSamples <= reference.samples.size();
+        if (replayed && captured) {
+            const float *replayedSamples = output.data() + outputPosition;
+            const float *capturedSamples = reference.samples.data() + referencePosition;
+            if (std::memcmp(replayedSamples, capturedSamples, numSamples * sizeof(float)) != 0) {
+                if (differingFrames == 0) {
+                    printf("first difference in frame %llu\n", static_cast<unsigned long long>(record.frameIndex));
+                }
+                differingFrames++;
+                for (size_t i = 0; i < numSamples; i++) {
+                    maxDifference = std::max(maxDifference, std::fabs(replayedSamples[i] - capturedSamples[i]));
+                }
+            }
+            comparedFrames++;
+        }
+        if (record.flags & kDumpMetaPreAlgoCaptured) {
+            outputPosition += numSamples;
+        }
+        if (record.flags & kDumpMetaPostAlgoCaptured) {
+            referencePosition += numSamples;
+        }
+    }
+    if (differingFrames > 0) {
+        printf("max absolute difference %g\n", maxDifference);
+    }
+    return differingFrames;
+}
+
+static std::string findSessionDump(const std::string &metaPath, const char *tapName)
+{
+    const std::string suffix = "frames.pdmeta";
+    if (metaPath.size() < suffix.size() || metaPath.compare(metaPath.size() - suffix.size(), suffix.size(), suffix)) {
+        return std::string();
+    }
+    const std::string prefix = metaPath.substr(0, metaPath.size() - suffix.size()) + tapName;
+    for (const char *extension : {".wav", ".pdz"}) {
+        if (std::filesystem::exists(prefix + extension)) {
+            return prefix + extension;
+        }
+    }
+    return std::string();
+}
+
+static int runReplay(int argc, char **argv)
+{
+    std::string metaPath, inputPath, referencePath, outputPath;
+    int repeat = 1;
+    for (int i = 0; i < argc; i++) {
+        const char *arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (strcmp(arg, "--input") == 0 && hasValue) {
+            inputPath = argv[++i];
+        } else if (strcmp(arg, "--reference") == 0 && hasValue) {
+            referencePath = argv[++i];
+        } else if (strcmp(arg, "--output") == 0 && hasValue) {
+            outputPath = argv[++i];
+        } else if (strcmp(arg, "--repeat") == 0 && hasValue) {
+            repeat = std::max(1, atoi(argv[++i]));
+        } else if (arg[0] == '-' || !metaPath.empty()) {
+            fprintf(stderr, "replay: unexpected argument %s\n", arg);
+            return 2;
+        } else {
+            metaPath = arg;
+        }
+    }
+    if (metaPath.empty()) {
+        fprintf(stderr, "replay: a session sidecar (.pdmeta) is required\n");
+        return 2;
+    }
+    if (inputPath.empty() && (inputPath = findSessionDump(metaPath, "pre_algo")).empty()) {
+        fprintf(stderr, "replay: no pre-algorithm dump next to \"%s\", capture with dumpTapPreAlgo on or pass "
+                        "--input\n",
+                metaPath.c_str());
+        return 2;
+    }
+    if (referencePath.empty()) {
+        referencePath = findSessionDump(metaPath, "processed");
+    }
+
+    DumpSession session;
+    DumpAudio input;
+    if (!loadDumpSession(metaPath, session) || !loadDumpAudio(inputPath, input)) {
+        return 1;
+    }
+    if (input.numChannels != session.numChannels) {
+        fprintf(stderr, "replay: \"%s\" has %u channels, the session %u\n", inputPath.c_str(), input.numChannels,
+                session.numChannels);
+        return 1;
+    }
+    char version[32] = {0};
+    get_algo_version(version);
+    printf("session: %zu frames, %u channels, %u Hz, algorithm %s, replaying with %s\n", session.records.size(),
+           session.numChannels, session.sampleRate, session.algoVersion, version);
+
+    bool doublePrecision = false;
+    for (const DumpFrameRecord &record : session.records) {
+        if (!(record.flags & kDumpMetaBypass)) {
+            doublePrecision = (record.flags & kDumpMetaDoublePrecision) != 0;
+            break;
+        }
+    }
+    if (doublePrecision) {
+        printf("processed in double precision, but dumped in float: bit-exact only if the host input fit a float\n");
+    }
+
+    std::vector<float> output;
+    ReplayStats stats;
+    double bestSeconds = 0;
+    for (int pass = 0; pass < repeat; pass++) {
+        bool replayed = doublePrecision ? replaySession<double>(session, input, output, stats)
+                                        : replaySession<float>(session, input, output, stats);
+        if (!replayed) {
+            return 1;
+        }
+        bestSeconds = pass == 0 ? stats.algoSeconds : std::min(bestSeconds, stats.algoSeconds);
+    }
+
+    double capturedMs = 0;
+    double maxCapturedMs = 0;
+    for (const DumpFrameRecord &record : session.records) {
+        if (!(record.flags & kDumpMetaBypass) && (record.flags & kDumpMetaPreAlgoCaptured)) {
+            capturedMs += record.processMs;
+            maxCapturedMs = std::max(maxCapturedMs, static_cast<double>(record.processMs));
+        }
+    }
+    const double audioSeconds = static_cast<double>(stats.processedSamples) / session.sampleRate;
+    printf("replayed %llu frames (%.3f s of audio), %llu bypassed, %llu missing from the dump\n",
+           static_cast<unsigned long long>(stats.processedFrames), audioSeconds,
+           static_cast<unsigned long long>(stats.bypassedFrames), static_cast<unsigned long long>(stats.missingFrames));
+    if (stats.processedFrames > 0) {
+        printf("algorithm time: best of %d %.6f s, %.1fx realtime, per frame mean %.4f ms max %.4f ms "
+               "(captured mean %.4f ms max %.4f ms)\n",
+               repeat, bestSeconds, bestSeconds > 0 ? audioSeconds / bestSeconds : 0.0,
+               bestSeconds * 1000.0 / static_cast<double>(stats.processedFrames), stats.maxFrameMs,
+               capturedMs / static_cast<double>(stats.processedFrames), maxCapturedMs);
+    }
+    if (stats.missingFrames > 0) {
+        printf("frames after the first missing one may differ, the algorithm state was not replayed for them\n");
+    }
+    if (stats.resultMismatches > 0) {
+        printf("%llu frames returned another algo_process result than in the session\n",
+               static_cast<unsigned long long>(stats.resultMismatches));
+    }
+
+    if (!outputPath.empty()) {
+        std::unique_ptr<FILE, int (*)(FILE *)> out(fopen(outputPath.c_str(), "wb"), &fclose);
+        uint8_t header[kWavHeaderBytes];
+        buildWavHeader(header, session.numChannels, session.sampleRate, 32, kWavFormatIEEEFloat,
+                       output.size() * sizeof(float));
+        if (!out || fwrite(header, 1, kWavHeaderBytes, out.get()) != kWavHeaderBytes ||
+            fwrite(output.data(), sizeof(float), output.size(), out.get()) != output.size() ||
+            fclose(out.release()) != 0) {
+            fprintf(stderr, "replay: cannot write \"%s\": %s\n", outputPath.c_str(), strerror(errno));
+            return 1;
+        }
+        printf("wrote %s\n", outputPath.c_str());
+    }
+
+    bool bitExact = stats.resultMismatches == 0;
+    if (!referencePath.empty()) {
+        DumpAudio reference;
+        if (!loadDumpAudio(referencePath, reference)) {
+            return 1;
+        }
+        uint64_t comparedFrames = 0;
+        uint64_t differingFrames = compareWithReference(session, output, reference, comparedFrames);
+        printf("compared %llu frames with %s: %s\n", static_cast<unsigned long long>(comparedFrames),
+               referencePath.c_str(),
+               differingFrames == 0 ? "bit-exact"
+                                    : (std::to_string(differingFrames) + " frames differ").c_str());
+        bitExact &= differingFrames == 0;
+    }
+    return bitExact ? 0 : 1;
+}
+
+// The formatter of the plugin logger before myLogFormatter, the baseline of bench-log
+static std::string formatLogLineLegacy(std::chrono::system_clock::time_point timestamp, std::thread::id threadId,
+                                       const std::string &processId, const char *level, const char *file, int line,
+                                       const char *function, const std::string &message)
+{
+    auto now_time_t = std::chrono::system_clock::to_time_t(timestamp);
+    auto now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(timestamp.time_since_epoch()) % 1000;
+    std::tm now_tm;
+#if defined(_WIN32)
+    localtime_s(&now_tm, &now_time_t);
+#else
+    localtime_r(&now_time_t, &now_tm);
+#endif
+
+    std::ostringstream timestampStr;
+    timestampStr << std::put_time(&now_tm, "%Y-%m-%d %H:%M:%S") << '.' << std::setfill('0') << std::setw(3)
+                 << now_ms.count();
+
+    std::ostringstream threadIdStr;
+    threadIdStr << threadId;
+
+    std::ostringstream logPrefix;
+    logPrefix << timestampStr.str() << " [" << processId << "." << threadIdStr.str() << "] " << level << " " << file
+              << ":" << line << " @" << function;
+
+    std::string logPrefixStr = logPrefix.str();
+    if (logPrefixStr.length() < 96) {
+        logPrefixStr.append(96 - logPrefixStr.length(), ' ');
+    }
+
+    std::ostringstream logMessage;
+    logMessage << logPrefixStr << " " << message;
+    return logMessage.str();
+}
+
+// Appends to the file the way juce::FileLogger::logMessage does, opening it for every call
+static bool appendToFile(const std::string &path, const std::string &text)
+{
+    FILE *file = fopen(path.c_str(), "ab");
+    if (file == nullptr) {
+        return false;
+    }
+    bool written = fwrite(text.data(), 1, text.size(), file) == text.size() && fwrite("\r\n", 1, 2, file) == 2;
+    return fclose(file) == 0 && written;
+}
+
+static int runBenchLog(int argc, char **argv)
+{
+    size_t numLines = 200000;
+    std::string path = (std::filesystem::temp_directory_path() / "DumpTools_bench.log").string();
+    for (int i = 0; i < argc; i++) {
+        const bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--lines") == 0 && hasValue) {
+            numLines = static_cast<size_t>(strtoull(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--file") == 0 && hasValue) {
+            path = argv[++i];
+        } else {
+            fprintf(stderr, "bench-log: unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+    if (numLines == 0) {
+        fprintf(stderr, "bench-log: --lines must be positive\n");
+        return 2;
+    }
+
+    // Messages like the ones the plugin logs, one every 20 us, a rate the worker fell behind at
+    static const char *const kMessages[] = {
+        "prepareToPlay: sampleRate=48000.000000, samplesPerBlock=512, about 10.666667 ms",
+        "internal frame size: 2048, set latency samples: 2048",
+        "Gain value has been set to 3.500000 dB",
+        "Created data dump file: \"/home/user/Desktop/Demo_DataDump/2024-07-06_152930_processed.wav\"",
+        "frame 1234: algo_process took 0.081 ms"};
+    const size_t numMessages = sizeof(kMessages) / sizeof(kMessages[0]);
+    std::vector<std::string> messages(kMessages, kMessages + numMessages);
+    const std::string processId = "12345";
+    const std::thread::id threadId = std::this_thread::get_id();
+    const auto start = std::chrono::system_clock::now();
+    auto timestampOf = [&](size_t i) { return start + std::chrono::microseconds(20 * i); };
+    auto secondsSince = [](std::chrono::steady_clock::time_point begin) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    };
+
+    // Formatting only
+    size_t legacyBytes = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < numLines; i++) {
+        legacyBytes += formatLogLineLegacy(timestampOf(i), threadId, processId, "INFO", "PluginProcessor.cpp", 345,
+                                           "prepareToPlay", messages[i % numMessages])
+                           .size();
+    }
+    const double legacyFormatSeconds = secondsSince(begin);
+
+    myLogFormatter formatter;
+    formatter.setProcessId(processId);
+    std::string line;
+    size_t bytes = 0;
+    begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < numLines; i++) {
+        line.clear();
+        const std::string &message = messages[i % numMessages];
+        formatter.append(line, timestampOf(i), threadId, "INFO", "PluginProcessor.cpp", 345, "prepareToPlay",
+                         message.data(), message.size());
+        bytes += line.size();
+    }
+    const double formatSeconds = secondsSince(begin);
+    if (bytes != legacyBytes) {
+        fprintf(stderr, "bench-log: the formatters produced %zu and %zu bytes\n", legacyBytes, bytes);
+        return 1;
+    }
+
+    // Both must produce the same lines
+    for (size_t i = 0; i < numLines; i += 997) {
+        line.clear();
+        const std::string &message = messages[i % numMessages];
+        formatter.append(line, timestampOf(i), threadId, "INFO", "PluginProcessor.cpp", 345, "prepareToPlay",
+                         message.data(), message.size());
+        if (line != formatLogLineLegacy(timestampOf(i), threadId, processId, "INFO", "PluginProcessor.cpp", 345,
+                                        "prepareToPlay", message)) {
+            fprintf(stderr, "bench-log: the formatters disagree on line %zu\n", i);
+            return 1;
+        }
+    }
+
+    // Formatting and writing, one file append per line before, one per 64 KiB batch now
+    std::filesystem::remove(path);
+    begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < numLines; i++) {
+        if (!appendToFile(path, formatLogLineLegacy(timestampOf(i), threadId, processId, "INFO",
+                                                    "PluginProcessor.cpp", 345, "prepareToPlay",
+                                                    messages[i % numMessages]))) {
+            fprintf(stderr, "bench-log: cannot write \"%s\": %s\n", path.c_str(), strerror(errno));
+            return 1;
+        }
+    }
+    const double legacyWriteSeconds = secondsSince(begin);
+
+    std::filesystem::remove(path);
+    std::string batch;
+    begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < numLines; i++) {
+        if (!batch.empty()) {
+            batch += "\r\n";
+        }
+        const std::string &message = messages[i % numMessages];
+        formatter.append(batch, timestampOf(i), threadId, "INFO", "PluginProcessor.cpp", 345, "prepareToPlay",
+                         message.data(), message.size());
+        if (batch.size() >= 64 * 1024 || i + 1 == numLines) {
+            if (!appendToFile(path, batch)) {
+                fprintf(stderr, "bench-log: cannot write \"%s\": %s\n", path.c_str(), strerror(errno));
+                return 1;
+            }
+            batch.clear();
+        }
+    }
+    const double writeSeconds = secondsSince(begin);
+    std::filesystem::remove(path);
+
+    printf("%zu lines, %zu bytes\n", numLines, bytes);
+    printf("             format only      format and write\n");
+    printf("before  %12.0f lines/s  %12.0f lines/s\n", numLines / legacyFormatSeconds, numLines / legacyWriteSeconds);
+    printf("after   %12.0f lines/s  %12.0f lines/s\n", numLines / formatSeconds, numLines / writeSeconds);
+    printf("speedup %12.1fx        %12.1fx\n", legacyFormatSeconds / formatSeconds, legacyWriteSeconds / writeSeconds);
+    return 0;
+}
+
+// Decodes one binary log into out, returns false if it cannot be read
+static bool decodeBinLog(const std::string &path, FILE *out, const std::string &outputPath)
+{
+    myBinLogReader reader;
+    if (!reader.open(path)) {
+        fprintf(stderr, "binlog2txt: \"%s\" cannot be read or is not a binary log\n", path.c_str());
+        return false;
+    }
+    // the lines the plugin logger would have written, with its formatter and line ends
+    myLogFormatter formatter;
+    myBinLogReader::Event event;
+    std::string text;
+    size_t numEvents = 0;
+    while (reader.next(event)) {
+        if (event.isNote) {
+            text += event.text;
+        } else {
+            formatter.setProcessId(event.processId);
+            formatter.append(text, event.timestamp, event.threadId, myLogFormatter::getLevelName(event.level),
+                             event.file.c_str(), event.line, event.function.c_str(), event.text.data(),
+                             event.text.size());
+        }
+        text += "\r\n";
+        numEvents++;
+        if (text.size() >= 64 * 1024) {
+            if (fwrite(text.data(), 1, text.size(), out) != text.size()) {
+                break;
+            }
+            text.clear();
+        }
+    }
+    if (fwrite(text.data(), 1, text.size(), out) != text.size() || fflush(out) != 0) {
+        fprintf(stderr, "binlog2txt: cannot write \"%s\": %s\n", outputPath.c_str(), strerror(errno));
+        return false;
+    }
+    if (reader.isDamaged()) {
+        fprintf(stderr, "binlog2txt: \"%s\" is truncated or corrupt after %zu lines\n", path.c_str(), numEvents);
+    }
+    return true;
+}
+
+static int runBinLog2Txt(int argc, char **argv)
+{
+    std::string output;
+    std::vector<std::string> inputs;
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        } else if (strncmp(argv[i], "--", 2) == 0) {
+            fprintf(stderr, "binlog2txt: unknown option %s\n", argv[i]);
+            return 2;
+        } else {
+            inputs.push_back(argv[i]);
+        }
+    }
+    if (inputs.empty()) {
+        fprintf(stderr, "binlog2txt: at least one input file is required\n");
+        return 2;
+    }
+
+    int failures = 0;
+    if (!output.empty()) {
+        FILE *out = output == "-" ? stdout : fopen(output.c_str(), "wb");
+        if (out == nullptr) {
+            fprintf(stderr, "binlog2txt: cannot create \"%s\": %s\n", output.c_str(), strerror(errno));
+            return 1;
+        }
+        for (const std::string &input : inputs) {
+            failures += decodeBinLog(input, out, output) ? 0 : 1;
+        }
+        if (out != stdout && fclose(out) != 0) {
+            fprintf(stderr, "binlog2txt: cannot write \"%s\": %s\n", output.c_str(), strerror(errno));
+            failures++;
+        }
+        return failures == 0 ? 0 : 1;
+    }
+    for (const std::string &input : inputs) {
+        const std::string outputPath = input + ".txt";
+        std::unique_ptr<FILE, int (*)(FILE *)> out(fopen(outputPath.c_str(), "wb"), &fclose);
+        if (!out) {
+            fprintf(stderr, "binlog2txt: cannot create \"%s\": %s\n", outputPath.c_str(), strerror(errno));
+            failures++;
+            continue;
+        }
+        failures += decodeBinLog(input, out.get(), outputPath) ? 0 : 1;
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        printUsage(argv[0]);
+        return 2;
+    }
+    if (strcmp(argv[1], "pcm2wav") == 0) {
+        return runPcm2Wav(argc - 2, argv + 2);
+    }
+    if (strcmp(argv[1], "pdz2wav") == 0) {
+        return runPdz2Wav(argc - 2, argv + 2);
+    }
+    if (strcmp(argv[1], "replay") == 0) {
+        return runReplay(argc - 2, argv + 2);
+    }
+    if (strcmp(argv[1], "bench-log") == 0) {
+        return runBenchLog(argc - 2, argv + 2);
+    }
+    if (strcmp(argv[1], "binlog2txt") == 0) {
+        return runBinLog2Txt(argc - 2, argv + 2);
+    }
+    printUsage(argv[0]);
+    return 2;
+}
@@ -0,0 +1,33 @@
+/***************************************************************************
+ * Description: Logging back end of the algorithm library inside DumpTools
+ * version: 0.1.0
+ * Author: Panda-Young
+ * Date: 2026-10-17 19:58:31
+ * Copyright (c) 2024 by Panda-Young, All Rights Reserved.
+ **************************************************************************/
+
+// The plugin logger needs the plugin; the tools only pass warnings and errors of the library on to stderr
+#include "../../../Source/myLogger.h"
+
+int log_level_enabled_c(LogLevel_t level)
+{
+    return level >= LOG_WARN && level < LOG_OFF;
+}
+
+void log_msg_c(LogLevel_t level, const char *message, const char *file, const char *function, int line,
+               LogSite_t *site)
+{
+    (void)site;
+    if (level >= LOG_WARN && level < LOG_OFF) {
+        fprintf(stderr, "[%s:%d %s] %s\n", file, line, function, message);
+    }
+}
+
+void log_rt_c(LogLevel_t level, LogSite_t *site, const double *args, int num_args)
+{
+    (void)args;
+    (void)num_args;
+    if (level >= LOG_WARN && level < LOG_OFF) {
+        fprintf(stderr, "[%s:%d %s] %s\n", site->file, site->line, site->function, site->format);
+    }
+}